@@ -0,0 +1,307 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "BuildHistory.h"
+
+#include <qdir.h>
+#include <qfileinfo.h>
+#include <qvarlengtharray.h>
+
+#include <algorithm>
+
+// Identifies the file and the version of its format. Files of another version are started over.
+constexpr const char* FILE_HEADER = "BMBH0002";
+constexpr qint64 FILE_HEADER_SIZE = 8;
+
+size_t ProjectBuildHistory::size() const
+{
+	return buildNumbers.size();
+}
+
+bool ProjectBuildHistory::empty() const
+{
+	return buildNumbers.empty();
+}
+
+quint32 ProjectBuildHistory::getDuration(size_t index) const
+{
+	return durations[index];
+}
+
+EProjectStatus ProjectBuildHistory::getStatus(size_t index) const
+{
+	return static_cast<EProjectStatus>(statuses[index]);
+}
+
+size_t ProjectBuildHistory::lowerBound(quint32 startTime) const
+{
+	return std::lower_bound(startTimes.begin(), startTimes.end(), startTime) - startTimes.begin();
+}
+
+void ProjectBuildHistory::append(qint32 buildNumber, quint32 startTime, quint32 duration, EProjectStatus status)
+{
+	buildNumbers.push_back(buildNumber);
+	startTimes.push_back(startTime);
+	durations.push_back(duration);
+	statuses.push_back(static_cast<quint8>(status));
+}
+
+BuildHistory::BuildHistory()
+{
+}
+
+bool BuildHistory::open(const QString& fileName)
+{
+	file.close();
+	projects.clear();
+	nameIndices.clear();
+	durationPredictor = DurationPredictor();
+
+	QFileInfo(fileName).dir().mkpath(".");
+	file.setFileName(fileName);
+	if (!file.open(QIODevice::ReadWrite))
+	{
+		return false;
+	}
+
+	qint64 validSize = 0;
+	if (file.size() >= FILE_HEADER_SIZE)
+	{
+		// Mapped instead of read, the file is only looked at once and can grow large.
+		if (uchar* mappedData = file.map(0, file.size()))
+		{
+			const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char*>(mappedData), static_cast<int>(file.size()));
+			if (data.startsWith(QByteArray::fromRawData(FILE_HEADER, FILE_HEADER_SIZE)))
+			{
+				load(data, validSize);
+			}
+			file.unmap(mappedData);
+		}
+	}
+
+	if (validSize == 0)
+	{
+		projects.clear();
+		nameIndices.clear();
+		durationPredictor = DurationPredictor();
+		file.resize(0);
+		file.write(FILE_HEADER, FILE_HEADER_SIZE);
+		validSize = FILE_HEADER_SIZE;
+	}
+	else if (validSize != file.size())
+	{
+		file.resize(validSize);
+	}
+
+	return file.seek(validSize);
+}
+
+void BuildHistory::record(const ProjectInformation& info)
+{
+	if (!file.isOpen() || info.isBuilding || info.buildNumber == 0 || info.buildStartTime <= 0)
+	{
+		return;
+	}
+
+	const quint32 startTime = static_cast<quint32>(info.buildStartTime / 1000);
+	qint32 lastBuildNumber = 0;
+	quint32 lastStartTime = 0;
+	const quint64 projectKey = info.getKey();
+	const QHash<quint64, ProjectBuildHistory>::const_iterator history = projects.constFind(projectKey);
+	if (history != projects.constEnd() && !history->empty())
+	{
+		lastBuildNumber = history->buildNumbers.back();
+		lastStartTime = history->startTimes.back();
+		if (info.buildNumber == lastBuildNumber || startTime < lastStartTime)
+		{
+			return; // Already recorded.
+		}
+	}
+
+	QByteArray record;
+	const quint32 serverIndex = getNameIndex(info.server, record);
+	const quint32 projectIndex = getNameIndex(info.projectName, record);
+	QVarLengthArray<quint32, 4> culpritIndices;
+	for (StringId culprit : info.initiatedBy)
+	{
+		culpritIndices.append(getNameIndex(culprit, record));
+	}
+
+	const qint64 buildNumberDelta = static_cast<qint64>(info.buildNumber) - lastBuildNumber;
+	const quint32 duration = static_cast<quint32>(std::max<qint64>(info.inProgressFor / 1000, 0));
+	writeVarint(record, static_cast<quint64>(ERecordType::Build));
+	writeVarint(record, serverIndex);
+	writeVarint(record, projectIndex);
+	writeVarint(record, (static_cast<quint64>(buildNumberDelta) << 1) ^ static_cast<quint64>(buildNumberDelta >> 63)); // Zigzag, jobs can be recreated.
+	writeVarint(record, startTime - lastStartTime);
+	writeVarint(record, duration);
+	writeVarint(record, static_cast<quint64>(info.status));
+	writeVarint(record, static_cast<quint64>(culpritIndices.size()));
+	for (quint32 culpritIndex : culpritIndices)
+	{
+		writeVarint(record, culpritIndex);
+	}
+
+	file.write(record);
+	file.flush();
+
+	addBuild(projectKey, info.buildNumber, startTime, duration, info.status);
+}
+
+const ProjectBuildHistory* BuildHistory::find(quint64 projectKey) const
+{
+	const QHash<quint64, ProjectBuildHistory>::const_iterator history = projects.constFind(projectKey);
+	return history != projects.constEnd() ? &history.value() : nullptr;
+}
+
+const DurationPredictor& BuildHistory::getDurationPredictor() const
+{
+	return durationPredictor;
+}
+
+void BuildHistory::load(const QByteArray& data, qint64& validSize)
+{
+	std::vector<StringId> names;
+	const char* position = data.constData() + FILE_HEADER_SIZE;
+	const char* end = data.constData() + data.size();
+	validSize = FILE_HEADER_SIZE;
+	while (position != end && loadRecord(position, end, names))
+	{
+		validSize = position - data.constData();
+	}
+
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		nameIndices.insert(names[i], static_cast<quint32>(i));
+	}
+}
+
+bool BuildHistory::loadRecord(const char*& position, const char* end, std::vector<StringId>& names)
+{
+	quint64 type = 0;
+	if (!readVarint(position, end, type))
+	{
+		return false;
+	}
+
+	if (type == static_cast<quint64>(ERecordType::Name))
+	{
+		quint64 length = 0;
+		if (!readVarint(position, end, length) || length > static_cast<quint64>(end - position))
+		{
+			return false;
+		}
+
+		names.push_back(StringTable::intern(QString::fromUtf8(position, static_cast<int>(length))));
+		position += length;
+		return true;
+	}
+
+	if (type != static_cast<quint64>(ERecordType::Build))
+	{
+		return false;
+	}
+
+	quint64 serverIndex = 0;
+	quint64 projectIndex = 0;
+	quint64 buildNumberDelta = 0;
+	quint64 startTimeDelta = 0;
+	quint64 duration = 0;
+	quint64 status = 0;
+	quint64 culpritCount = 0;
+	if (!readVarint(position, end, serverIndex) || !readVarint(position, end, projectIndex) ||
+		!readVarint(position, end, buildNumberDelta) ||
+		!readVarint(position, end, startTimeDelta) || !readVarint(position, end, duration) ||
+		!readVarint(position, end, status) || !readVarint(position, end, culpritCount) ||
+		serverIndex >= names.size() || projectIndex >= names.size() || status > static_cast<quint64>(EProjectStatus::Unknown))
+	{
+		return false;
+	}
+
+	// Culprits are only kept in the file.
+	for (quint64 i = 0; i < culpritCount; ++i)
+	{
+		quint64 culpritIndex = 0;
+		if (!readVarint(position, end, culpritIndex) || culpritIndex >= names.size())
+		{
+			return false;
+		}
+	}
+
+	const quint64 projectKey = ProjectInformation::makeKey(names[serverIndex], names[projectIndex]);
+	const ProjectBuildHistory& history = projects[projectKey];
+	const qint32 lastBuildNumber = history.empty() ? 0 : history.buildNumbers.back();
+	const quint32 lastStartTime = history.empty() ? 0 : history.startTimes.back();
+	const qint64 delta = static_cast<qint64>(buildNumberDelta >> 1) ^ -static_cast<qint64>(buildNumberDelta & 1);
+	addBuild(projectKey, static_cast<qint32>(lastBuildNumber + delta), static_cast<quint32>(lastStartTime + startTimeDelta),
+		static_cast<quint32>(duration), static_cast<EProjectStatus>(status));
+	return true;
+}
+
+void BuildHistory::addBuild(quint64 projectKey, qint32 buildNumber, quint32 startTime, quint32 duration, EProjectStatus status)
+{
+	projects[projectKey].append(buildNumber, startTime, duration, status);
+
+	// Failed and aborted builds tend to stop early, their duration says little about the next build.
+	if (status == EProjectStatus::Succeeded || status == EProjectStatus::Unstable)
+	{
+		durationPredictor.addDuration(projectKey, duration);
+	}
+}
+
+quint32 BuildHistory::getNameIndex(StringId name, QByteArray& record)
+{
+	const QHash<StringId, quint32>::const_iterator nameIndex = nameIndices.constFind(name);
+	if (nameIndex != nameIndices.constEnd())
+	{
+		return nameIndex.value();
+	}
+
+	// Names are written ahead of the build that first refers to them, as part of the same record.
+	const QByteArray utf8Name = StringTable::get(name).toUtf8();
+	writeVarint(record, static_cast<quint64>(ERecordType::Name));
+	writeVarint(record, static_cast<quint64>(utf8Name.size()));
+	record += utf8Name;
+
+	const quint32 index = static_cast<quint32>(nameIndices.size());
+	nameIndices.insert(name, index);
+	return index;
+}
+
+void BuildHistory::writeVarint(QByteArray& record, quint64 value)
+{
+	while (value >= 0x80)
+	{
+		record += static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	record += static_cast<char>(value);
+}
+
+bool BuildHistory::readVarint(const char*& position, const char* end, quint64& value)
+{
+	value = 0;
+	for (qint32 shift = 0; position != end && shift < 64; shift += 7)
+	{
+		const quint8 byte = static_cast<quint8>(*position++);
+		value |= static_cast<quint64>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
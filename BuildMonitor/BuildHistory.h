@@ -0,0 +1,93 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "DurationPredictor.h"
+#include "ProjectInformation.h"
+
+#include <qfile.h>
+#include <qhash.h>
+
+#include <vector>
+
+// Finished builds of a single project in order of their start. Every field is stored in an array of its own,
+// so a range of builds can be scanned for a single field without touching the others.
+class ProjectBuildHistory
+{
+public:
+	size_t size() const;
+	bool empty() const;
+
+	quint32 getDuration(size_t index) const; // In seconds.
+	EProjectStatus getStatus(size_t index) const;
+
+	// Index of the first build that started at or after the time, for range queries.
+	size_t lowerBound(quint32 startTime) const;
+
+private:
+	friend class BuildHistory;
+
+	void append(qint32 buildNumber, quint32 startTime, quint32 duration, EProjectStatus status);
+
+	std::vector<qint32> buildNumbers;
+	std::vector<quint32> startTimes; // In seconds since epoch.
+	std::vector<quint32> durations;
+	std::vector<quint8> statuses;
+};
+
+// Records every finished build of the monitored projects in an append-only file, and keeps them in memory
+// for queries. Only builds are recorded, refreshes that find nothing new don't grow the file.
+//
+// The file holds names, including those of the servers, once and refers to them by index. Build numbers and start times are stored relative to
+// the previous build of the same project, and all integers are variable length. A build takes about eleven bytes.
+class BuildHistory
+{
+public:
+	BuildHistory();
+
+	// Loads the recorded builds, a file that ends in a partially written record is cut off before it.
+	bool open(const QString& fileName);
+
+	// Builds that are in progress or were recorded before are ignored.
+	void record(const ProjectInformation& info);
+
+	// Returns nullptr for projects without recorded builds. Projects are identified by their key.
+	const ProjectBuildHistory* find(quint64 projectKey) const;
+
+	// Fed with the duration of every build that succeeded, possibly unstable.
+	const DurationPredictor& getDurationPredictor() const;
+
+private:
+	enum class ERecordType : quint8
+	{
+		Name,
+		Build
+	};
+
+	void load(const QByteArray& data, qint64& validSize);
+	bool loadRecord(const char*& position, const char* end, std::vector<StringId>& names);
+	void addBuild(quint64 projectKey, qint32 buildNumber, quint32 startTime, quint32 duration, EProjectStatus status);
+	quint32 getNameIndex(StringId name, QByteArray& record);
+
+	static void writeVarint(QByteArray& record, quint64 value);
+	static bool readVarint(const char*& position, const char* end, quint64& value);
+
+	QFile file;
+	QHash<quint64, ProjectBuildHistory> projects;
+	QHash<StringId, quint32> nameIndices; // Of the names that are written to the file.
+	DurationPredictor durationPredictor;
+};
@@ -0,0 +1,89 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BuildHistoryDelegate.h"
+
+#include "BuildHistory.h"
+#include "ProjectTableModel.h"
+
+#include <qpainter.h>
+
+#include <algorithm>
+
+constexpr size_t SPARKLINE_BUILDS = 20;
+constexpr qint32 SPARKLINE_BAR_WIDTH = 4;
+constexpr qint32 SPARKLINE_MINIMUM_BAR_HEIGHT = 2;
+constexpr qint32 SPARKLINE_MARGIN = 2;
+
+static QColor getStatusColor(EProjectStatus status)
+{
+	switch (status)
+	{
+	case EProjectStatus::Succeeded: return QColor(76, 175, 80);
+	case EProjectStatus::Unstable: return QColor(251, 192, 45);
+	case EProjectStatus::Failed: return QColor(229, 57, 53);
+	default: return QColor(158, 158, 158);
+	}
+}
+
+BuildHistoryDelegate::BuildHistoryDelegate(QObject* parent) :
+	QStyledItemDelegate(parent),
+	buildHistory(nullptr)
+{
+}
+
+void BuildHistoryDelegate::setBuildHistory(const BuildHistory* inBuildHistory)
+{
+	buildHistory = inBuildHistory;
+}
+
+void BuildHistoryDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+	QStyledItemDelegate::paint(painter, option, index); // Background and selection.
+
+	const ProjectTableModel* model = qobject_cast<const ProjectTableModel*>(index.model());
+	const ProjectInformation* info = model != nullptr ? model->getProject(index.row()) : nullptr;
+	const ProjectBuildHistory* history = info != nullptr && buildHistory != nullptr ? buildHistory->find(info->getKey()) : nullptr;
+	if (history == nullptr || history->empty())
+	{
+		return;
+	}
+
+	const size_t end = history->size();
+	const size_t begin = end - std::min(end, SPARKLINE_BUILDS);
+	quint32 longestDuration = 1;
+	for (size_t i = begin; i < end; ++i)
+	{
+		longestDuration = std::max(longestDuration, history->getDuration(i));
+	}
+
+	const QRect area = option.rect.adjusted(SPARKLINE_MARGIN, SPARKLINE_MARGIN, -SPARKLINE_MARGIN, -SPARKLINE_MARGIN);
+	for (size_t i = begin; i < end; ++i)
+	{
+		const qint32 height = std::max(static_cast<qint32>(static_cast<qint64>(area.height()) * history->getDuration(i) / longestDuration),
+			SPARKLINE_MINIMUM_BAR_HEIGHT);
+		const QRect bar(area.left() + static_cast<qint32>(i - begin) * SPARKLINE_BAR_WIDTH, area.bottom() - height + 1,
+			SPARKLINE_BAR_WIDTH - 1, height);
+		painter->fillRect(bar.intersected(area), getStatusColor(history->getStatus(i)));
+	}
+}
+
+QSize BuildHistoryDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+	const QSize size = QStyledItemDelegate::sizeHint(option, index);
+	return QSize(static_cast<qint32>(SPARKLINE_BUILDS) * SPARKLINE_BAR_WIDTH + 2 * SPARKLINE_MARGIN, size.height());
+}
@@ -0,0 +1,35 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <qstyleditemdelegate.h>
+
+// Draws the most recent builds of a project as a row of bars, colored by their status and as high as their
+// duration relative to the longest one shown.
+class BuildHistoryDelegate : public QStyledItemDelegate
+{
+public:
+	BuildHistoryDelegate(QObject* parent);
+
+	void setBuildHistory(const class BuildHistory* buildHistory);
+
+	virtual void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+	virtual QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+private:
+	const class BuildHistory* buildHistory;
+};
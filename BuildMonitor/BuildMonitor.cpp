@@ -19,6 +19,7 @@
 
 #include "BuildMonitorServerCommunication.h"
 #include "JenkinsCommunication.h"
+#include "ProjectChangeSet.h"
 #include "ProjectPickerDialog.h"
 #include "ProjectInformation.h"
 #include "Settings.h"
@@ -50,6 +51,8 @@ BuildMonitor::BuildMonitor(QWidget *parent) :
 	buildMonitorServerCommunication(new BuildMonitorServerCommunication(this)),
 	jenkins(new JenkinsCommunication(this)),
 	projectBuildStatusGlobal(EProjectStatus::Unknown),
+	projectBuildStatusGlobalIsBuilding(false),
+	isTableOutdated(false),
 	exitApplication(false)
 {
 	ui.setupUi(this);
@@ -58,6 +61,7 @@ BuildMonitor::BuildMonitor(QWidget *parent) :
 
 	connect(&settings, &Settings::settingsChanged, this, &BuildMonitor::onSettingsChanged);
 	jenkins->setSettings(&settings);
+	ui.serverOverviewTable->setBuildHistory(&jenkins->getBuildHistory());
 	if (!settings.loadSettings())
 	{
 		onSettingsChanged();
@@ -72,6 +76,7 @@ BuildMonitor::BuildMonitor(QWidget *parent) :
 
 	connect(jenkins, &JenkinsCommunication::projectInformationError, this, &BuildMonitor::onProjectInformationError);
 	connect(jenkins, &JenkinsCommunication::projectInformationUpdated, this, &BuildMonitor::onProjectInformationUpdated);
+	jenkins->loadCachedProjectInformation();
 
 	connect(buildMonitorServerCommunication, &BuildMonitorServerCommunication::onFixInformationUpdated, this, &BuildMonitor::onFixInformationUpdated);
 
@@ -148,6 +153,7 @@ void BuildMonitor::closeEvent(QCloseEvent* event)
 	settings.saveSettings();
 	if (exitApplication)
 	{
+		jenkins->saveCachedProjectInformation();
 		close();
 	}
 	else
@@ -201,11 +207,12 @@ void BuildMonitor::updateIcons()
 void BuildMonitor::updateTaskbarProgress()
 {
 #if _MSC_VER
-	if (!settings.showProgressForProject.isEmpty())
+	const StringId showProgressForProject = StringTable::find(settings.showProgressForProject);
+	if (showProgressForProject != 0)
 	{
 		for (const ProjectInformation& info : lastProjectInformation)
 		{
-			if (info.projectName == settings.showProgressForProject)
+			if (info.projectName == showProgressForProject)
 			{
 				if (info.isBuilding)
 				{
@@ -357,87 +364,75 @@ void BuildMonitor::onTrayContextActionExecuted(TrayContextAction action)
 	}
 }
 
-void BuildMonitor::onProjectInformationUpdated(const std::vector<ProjectInformation>& projectInformation)
+void BuildMonitor::onProjectInformationUpdated(const ProjectSnapshot& projectInformation)
 {
-	for (size_t index = 0; index < lastProjectInformation.size(); ++index)
+	if (projectInformation.isStale())
 	{
-		auto switchedToFailed = [](const ProjectInformation& last, const ProjectInformation& now)
-		{
-			return projectStatus_isFailure(now.status) && last.status == EProjectStatus::Succeeded;
-		};
+		ui.statusBar->showMessage("Showing the projects of the last session until refreshed.");
+	}
+	else if (lastProjectInformation.isStale())
+	{
+		ui.statusBar->clearMessage();
+	}
 
-		auto switchedToSuccess = [](const ProjectInformation& last, const ProjectInformation& now)
-		{
-			return now.status == EProjectStatus::Succeeded && projectStatus_isFailure(last.status);
-		};
+	const ProjectChangeSet changeSet(lastProjectInformation, projectInformation);
+	const bool staleServersChanged = projectInformation.getStaleServers() != lastProjectInformation.getStaleServers() ||
+		projectInformation.getCachedServers() != lastProjectInformation.getCachedServers();
+	lastProjectInformation = projectInformation;
 
-		if (tray->supportsMessages())
+	if (tray->supportsMessages())
+	{
+		auto showMessage = [this](const ProjectInformation& info, bool broken)
 		{
-			auto showMessage = [this](const QString& projectName, const std::vector<QString>& initiators, bool broken)
-			{
-				QString message(broken ? "Broken by: " : "Fixed by: ");
-				if (initiators.empty())
-				{
-					message += "Unknown";
-				}
-				else
-				{
-					for (size_t i = 0; i < initiators.size(); ++i)
-					{
-						if (i != 0)
-						{
-							if (i == initiators.size() - 1)
-							{
-								message += " and/or ";
-							}
-							else
-							{
-								message += ", ";
-							}
-						}
-
-						message += initiators[i];
-					}
-				}
-				tray->showMessage(projectName, message, broken ? QSystemTrayIcon::Critical : QSystemTrayIcon::Information, 3000);
-			};
-
-			if (projectInformation.size() < index && lastProjectInformation.size() < index &&
-					projectInformation[index].projectName == lastProjectInformation[index].projectName)
+			QString message(broken ? "Broken by: " : "Fixed by: ");
+			if (info.initiatedBy.empty())
 			{
-				if (switchedToFailed(lastProjectInformation[index], projectInformation[index]))
-				{
-					showMessage(projectInformation[index].projectName, projectInformation[index].initiatedBy, true);
-				}
-				else if (switchedToSuccess(lastProjectInformation[index], projectInformation[index]))
-				{
-					showMessage(projectInformation[index].projectName, projectInformation[index].initiatedBy, false);
-				}
+				message += "Unknown";
 			}
 			else
 			{
-				for (const ProjectInformation& info : projectInformation)
+				for (qint32 i = 0; i < info.initiatedBy.size(); ++i)
 				{
-					if (info.projectName == lastProjectInformation[index].projectName)
+					if (i != 0)
 					{
-						if (switchedToFailed(lastProjectInformation[index], info))
+						if (i == info.initiatedBy.size() - 1)
 						{
-							showMessage(info.projectName, info.initiatedBy, true);
+							message += " and/or ";
 						}
-						else if (switchedToSuccess(lastProjectInformation[index], info))
+						else
 						{
-							showMessage(info.projectName, info.initiatedBy, false);
+							message += ", ";
 						}
-						break;
 					}
+
+					message += StringTable::get(info.initiatedBy[i]);
 				}
 			}
+			tray->showMessage(info.getProjectName(), message, broken ? QSystemTrayIcon::Critical : QSystemTrayIcon::Information, 3000);
+		};
+
+		for (const ProjectChange& change : changeSet.getChanges())
+		{
+			if (change.type == EProjectChange::Broke || change.type == EProjectChange::Fixed)
+			{
+				showMessage(projectInformation[change.index], change.type == EProjectChange::Broke);
+			}
 		}
 	}
 
+	isTableOutdated |= !changeSet.isEmpty() || staleServersChanged;
 
-	lastProjectInformation = projectInformation;
+	if (changeSet.affectsStatus() || staleServersChanged || projectBuildStatusGlobal == EProjectStatus::Unknown)
+	{
+		updateGlobalStatus();
+	}
+	updateTaskbarProgress();
+
+	buildMonitorServerCommunication->requestFixInformation(lastProjectInformation.getProjects());
+}
 
+void BuildMonitor::updateGlobalStatus()
+{
 	static const std::vector<EProjectStatus> priorityList = {
 		EProjectStatus::Failed,
 		EProjectStatus::Unstable,
@@ -450,8 +445,13 @@ void BuildMonitor::onProjectInformationUpdated(const std::vector<ProjectInformat
 	size_t newStatusIndex = priorityList.size() - 1;
 
 	bool isBuilding = false;
-	for (const ProjectInformation& info : projectInformation)
+	for (const ProjectInformation& info : lastProjectInformation)
 	{
+		if (lastProjectInformation.isServerStale(info.server))
+		{
+			continue; // Unknown until the server can be reached again, cached projects count as last known.
+		}
+
 		size_t statusIndex = std::find(priorityList.begin(), priorityList.end(), info.status) - priorityList.begin();
 		if (statusIndex < newStatusIndex)
 		{
@@ -466,81 +466,79 @@ void BuildMonitor::onProjectInformationUpdated(const std::vector<ProjectInformat
 		projectBuildStatusGlobalIsBuilding = isBuilding;
 		updateIcons();
 	}
-	updateTaskbarProgress();
-
-	buildMonitorServerCommunication->requestFixInformation(lastProjectInformation);
 }
 
 void BuildMonitor::onFixInformationUpdated(const std::vector<FixInformation>& fixInformation)
 {
+	QHash<StringId, StringId> newVolunteers;
 	for (const FixInformation& info : fixInformation)
 	{
-		const std::vector<ProjectInformation>::iterator pos = std::find_if(lastProjectInformation.begin(), lastProjectInformation.end(),
-			[&info](const ProjectInformation& projectInfo)
+		// The fix server only knows project names, jobs of the same name on several servers share their fix.
+		const StringId projectName = StringTable::find(info.projectName);
+		bool isFailing = false;
+		const ProjectInformation* fixedProject = nullptr;
+		for (const ProjectInformation& projectInfo : lastProjectInformation)
 		{
-			return projectInfo.projectName == info.projectName;
-		});
-
-		if (pos != lastProjectInformation.end())
-		{
-			if (pos->buildNumber >= info.buildNumber)
+			if (projectInfo.projectName == projectName && projectInfo.buildNumber >= info.buildNumber)
 			{
-				if (projectStatus_isFailure(pos->status))
+				if (projectStatus_isFailure(projectInfo.status))
 				{
-					pos->volunteer = info.userName;
+					isFailing = true;
 				}
 				else
 				{
-					buildMonitorServerCommunication->requestReportFixed(pos->projectName, pos->buildNumber);
+					fixedProject = &projectInfo;
 				}
 			}
 		}
+
+		if (isFailing)
+		{
+			newVolunteers.insert(projectName, StringTable::intern(info.userName));
+		}
+		else if (fixedProject != nullptr)
+		{
+			buildMonitorServerCommunication->requestReportFixed(fixedProject->getProjectName(), fixedProject->buildNumber);
+		}
 	}
 
-	ui.serverOverviewTable->setProjectInformation(lastProjectInformation);
+	if (isTableOutdated || newVolunteers != volunteers)
+	{
+		volunteers = newVolunteers;
+		isTableOutdated = false;
+		ui.serverOverviewTable->setProjectInformation(lastProjectInformation, volunteers);
+	}
 }
 
 void BuildMonitor::onProjectInformationError(const QString& errorMessage)
 {
-	if (projectBuildStatusGlobal != EProjectStatus::Unknown)
-	{
-		projectBuildStatusGlobal = EProjectStatus::Unknown;
-		updateIcons();
-	}
+	// The global status follows once the projects of the server are published as stale.
 	ui.statusBar->showMessage(errorMessage);
 }
 
 void BuildMonitor::onTableRowDoubleClicked(const QModelIndex& index)
 {
-	const QString projectName = ui.serverOverviewTable->getProjectName(index.row());
-	for (const ProjectInformation& info : lastProjectInformation)
+	const ProjectInformation* info = ui.serverOverviewTable->getProject(index.row());
+	if (info != nullptr)
 	{
-		if (info.projectName == projectName)
-		{
-			QDesktopServices::openUrl(info.projectUrl);
-			break;
-		}
+		QDesktopServices::openUrl(info->getProjectUrl());
 	}
 }
 
-void BuildMonitor::onVolunteerToFix(const QString& projectName)
+void BuildMonitor::onVolunteerToFix(const ProjectInformation& project)
 {
-	const std::vector<ProjectInformation>::const_iterator pos = std::find_if(lastProjectInformation.begin(), lastProjectInformation.end(),
-		[&projectName](const ProjectInformation& element) { return element.projectName == projectName; });
-	if (pos != lastProjectInformation.end() && projectStatus_isFailure(pos->status))
+	if (projectStatus_isFailure(project.status))
 	{
-		buildMonitorServerCommunication->requestReportFixing(projectName, pos->buildNumber);
+		buildMonitorServerCommunication->requestReportFixing(project.getProjectName(), project.buildNumber);
 		jenkins->refresh();
 	}
 }
 
-void BuildMonitor::onViewBuildLog(const QString& projectName)
+void BuildMonitor::onViewBuildLog(const ProjectInformation& project)
 {
-	const std::vector<ProjectInformation>::const_iterator pos = std::find_if(lastProjectInformation.begin(), lastProjectInformation.end(),
-		[&projectName](const ProjectInformation& element) { return element.projectName == projectName; });
-	if (pos != lastProjectInformation.end() && pos->buildNumber != 0)
+	if (project.buildNumber != 0)
 	{
-		QDesktopServices::openUrl(pos->projectUrl.toString() + QString::number(pos->buildNumber) + "/consoleText");
+		QDesktopServices::openUrl(project.getProjectUrl().toString() + QString::number(project.buildNumber) + "/consoleText");
 	}
 }
 
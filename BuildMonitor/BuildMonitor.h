@@ -19,6 +19,7 @@
 
 #include "FixInformation.h"
 #include "ProjectInformation.h"
+#include "ProjectSnapshot.h"
 #include "ProjectStatus.h"
 #include "Settings.h"
 #include "TrayContextAction.h"
@@ -46,6 +47,7 @@ public:
 
 private:
 	void updateIcons();
+	void updateGlobalStatus();
 	void updateTaskbarProgress();
 	void showWindow();
 	void addToStartup();
@@ -58,12 +60,12 @@ private:
 	void onSettingsChanged();
 	void onTrayActivated(QSystemTrayIcon::ActivationReason reason);
 	void onTrayContextActionExecuted(TrayContextAction action);
-	void onProjectInformationUpdated(const std::vector<ProjectInformation>& projectInformation);
+	void onProjectInformationUpdated(const ProjectSnapshot& projectInformation);
 	void onFixInformationUpdated(const std::vector<FixInformation>& fixInformation);
 	void onProjectInformationError(const QString& errorMessage);
 	void onTableRowDoubleClicked(const class QModelIndex& index);
-	void onVolunteerToFix(const QString& projectName);
-	void onViewBuildLog(const QString& projectName);
+	void onVolunteerToFix(const ProjectInformation& project);
+	void onViewBuildLog(const ProjectInformation& project);
 	void toggleVisibility();
 
 	Ui::BuildMonitorClass ui;
@@ -82,6 +84,8 @@ private:
 	class JenkinsCommunication* jenkins;
 	EProjectStatus projectBuildStatusGlobal;
 	bool projectBuildStatusGlobalIsBuilding;
-	std::vector<ProjectInformation> lastProjectInformation;
+	ProjectSnapshot lastProjectInformation;
+	QHash<StringId, StringId> volunteers; // User that volunteered to fix a project, by project name.
+	bool isTableOutdated;
 	bool exitApplication;
 };
@@ -9,36 +9,74 @@ win32:QT += winextras
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+# Functor based QMetaObject::invokeMethod, QRandomGenerator and QDataStream::Qt_5_10 are used.
+lessThan(QT_MAJOR_VERSION, 5)|if(equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 10)) {
+    error("Qt 5.10 or newer is required.")
+}
+
 TARGET = BuildMonitor
 TEMPLATE = app
 unix:QMAKE_CXXFLAGS += -std=c++11
 
+INCLUDEPATH += ../Shared
+
 SOURCES += main.cpp\
+    BuildHistory.cpp \
+    BuildHistoryDelegate.cpp \
     BuildMonitor.cpp \
     BuildMonitorServerCommunication.cpp \
     BuildMonitorServerWorker.cpp \
+    DurationPredictor.cpp \
     JenkinsCommunication.cpp \
+    JenkinsEventStream.cpp \
+    JenkinsJobListParser.cpp \
+    JenkinsParseWorker.cpp \
+    JenkinsRequestScheduler.cpp \
+    ProjectChangeSet.cpp \
+    ProjectFilter.cpp \
+    ProjectInformationCache.cpp \
 	ProjectPickerDialog.cpp \
+    ProjectTableModel.cpp \
     ServerOverviewTable.cpp \
     Settings.cpp \
     SettingsDialog.cpp \
-    TrayContextMenu.cpp
+    StringTable.cpp \
+    TrayContextMenu.cpp \
+    ../Shared/FixMessage.cpp \
+    ../Shared/MessageFraming.cpp
 
 HEADERS  += \
+    BuildHistory.h \
+    BuildHistoryDelegate.h \
     BuildMonitor.h \
     BuildMonitorServerCommunication.h \
     BuildMonitorServerWorker.h \
+    DurationPredictor.h \
     FixInformation.h \
     JenkinsCommunication.h \
+    JenkinsEventStream.h \
+    JenkinsJobInformation.h \
+    JenkinsJobListParser.h \
+    JenkinsParseWorker.h \
+    JenkinsRequestScheduler.h \
+    JenkinsResponseCache.h \
+    ProjectChangeSet.h \
+    ProjectFilter.h \
 	ProjectPickerDialog.h \
     ProjectInformation.h \
+    ProjectInformationCache.h \
+    ProjectSnapshot.h \
     ProjectStatus.h \
+    ProjectTableModel.h \
     ServerOverviewTable.h \
     Settings.h \
     SettingsDialog.h \
     SingleInstanceMode.h \
+    StringTable.h \
     TrayContextAction.h \
-    TrayContextMenu.h
+    TrayContextMenu.h \
+    ../Shared/FixMessage.h \
+    ../Shared/MessageFraming.h
 
 FORMS    += BuildMonitor.ui \
 	ProjectPicker.ui \
@@ -19,9 +19,6 @@
 
 #include "ProjectInformation.h"
 
-#include <qjsonarray.h>
-#include <qjsondocument.h>
-#include <qjsonobject.h>
 #include <qthread.h>
 
 constexpr quint16 SERVER_DEFAULT_PORT = 1080;
@@ -32,7 +29,7 @@ BuildMonitorServerCommunication::BuildMonitorServerCommunication(QObject* parent
 	worker(new BuildMonitorServerWorker(*workerThread))
 {
 	connect(this, &BuildMonitorServerCommunication::processQueue, worker, &BuildMonitorServerWorker::processQueue);
-	connect(worker, &BuildMonitorServerWorker::responseGenerated, this, &BuildMonitorServerCommunication::onResponseGenerated);
+	connect(worker, &BuildMonitorServerWorker::responseReceived, this, &BuildMonitorServerCommunication::onResponseReceived);
 	connect(worker, &BuildMonitorServerWorker::failure, this, &BuildMonitorServerCommunication::onFailure);
 	
 	workerThread->setObjectName("BuildMonitorServerCommunicationThread");
@@ -76,83 +73,48 @@ void BuildMonitorServerCommunication::requestFixInformation(const std::vector<cl
 {
 	if (!worker->containsRequestType(BuildMonitorRequestType::FixInformation))
 	{
-		QJsonObject root;
-		root["version"] = 1;
-		root["request_type"] = "fix_state";
-		QJsonObject requestInfo;
-		QJsonArray projectsArray;
+		BuildMonitorServerWorker::Request request(BuildMonitorRequestType::FixInformation);
+		request.projectNames.reserve(projects.size());
 		for (const ProjectInformation& info : projects)
 		{
-			projectsArray.push_back(info.projectName);
+			request.projectNames.push_back(info.getProjectName());
 		}
-		requestInfo["projects"] = projectsArray;
-		root["request_info"] = requestInfo;
-		QJsonDocument doc;
-		doc.setObject(root);
 
-		worker->addToQueue(BuildMonitorServerWorker::Request(doc.toBinaryData(), BuildMonitorRequestType::FixInformation));
+		worker->addToQueue(request);
 		emit processQueue();
 	}
 }
 
 void BuildMonitorServerCommunication::requestReportFixing(const QString& projectName, const qint32 buildNumber)
 {
-	QJsonObject root;
-	root["version"] = 1;
-	root["request_type"] = "report_fixing";
-	QJsonObject requestInfo;
-	requestInfo["project_name"] = projectName;
-	QString userName = qgetenv("USER");
-	if (userName.isEmpty())
+	BuildMonitorServerWorker::Request request(BuildMonitorRequestType::ReportFixing);
+	request.projectName = projectName;
+	request.userName = qgetenv("USER");
+	if (request.userName.isEmpty())
 	{
-		userName = qgetenv("USERNAME");
+		request.userName = qgetenv("USERNAME");
 	}
-	requestInfo["user_name"] = userName;
-	requestInfo["build_number"] = buildNumber;
-	root["request_info"] = requestInfo;
-	QJsonDocument doc;
-	doc.setObject(root);
+	request.buildNumber = buildNumber;
 
-	worker->addToQueue(BuildMonitorServerWorker::Request(doc.toBinaryData(), BuildMonitorRequestType::ReportFixing));
+	worker->addToQueue(request);
 	emit processQueue();
 }
 
 void BuildMonitorServerCommunication::requestReportFixed(const QString& projectName, const qint32 buildNumber)
 {
-	QJsonObject root;
-	root["version"] = 1;
-	root["request_type"] = "mark_fixed";
-	QJsonObject requestInfo;
-	requestInfo["project_name"] = projectName;
-	requestInfo["build_number"] = buildNumber;
-	root["request_info"] = requestInfo;
-	QJsonDocument doc;
-	doc.setObject(root);
-
-	worker->addToQueue(BuildMonitorServerWorker::Request(doc.toBinaryData(), BuildMonitorRequestType::ReportFixed));
+	BuildMonitorServerWorker::Request request(BuildMonitorRequestType::ReportFixed);
+	request.projectName = projectName;
+	request.buildNumber = buildNumber;
+
+	worker->addToQueue(request);
 	emit processQueue();
 }
 
-void BuildMonitorServerCommunication::onResponseGenerated(QByteArray data)
+void BuildMonitorServerCommunication::onResponseReceived(BuildMonitorRequestType type, const std::vector<FixInformation>& receivedFixInformation)
 {
-	const QJsonDocument json = QJsonDocument::fromBinaryData(data);
-	const QJsonObject root = json.object();
-	if (root["version"].toInt() == 1)
+	if (type == BuildMonitorRequestType::FixInformation)
 	{
-		if (root["response_type"].toString() == "fix_state")
-		{
-			fixInformation.clear();
-			QJsonArray responseInfo = root["response_info"].toArray();
-			for (const QJsonValue& value : responseInfo)
-			{
-				const QJsonObject object = value.toObject();
-				fixInformation.emplace_back(
-					object["project_name"].toString(),
-					object["user_name"].toString(),
-					object["build_number"].toInt()
-				);
-			}
-		}
+		fixInformation = receivedFixInformation;
 	}
 
 	onFixInformationUpdated(fixInformation);
@@ -43,7 +43,7 @@ Q_SIGNALS:
 
 private slots:
 	void onFailure(BuildMonitorRequestType type);
-	void onResponseGenerated(QByteArray data);
+	void onResponseReceived(BuildMonitorRequestType type, const std::vector<FixInformation>& receivedFixInformation);
 
 private:
 	class QThread* workerThread;
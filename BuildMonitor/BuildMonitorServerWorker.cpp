@@ -18,19 +18,105 @@
 #include "BuildMonitorServerWorker.h"
 
 #include <qapplication.h>
+#include <qdatetime.h>
 #include <qdebug.h>
+#include <qjsonarray.h>
+#include <qjsondocument.h>
+#include <qjsonobject.h>
 #include <qthread.h>
+#include <qtimer.h>
+
+#include <algorithm>
+
+constexpr qint32 CONNECT_TIMEOUT_MS = 3000;
+constexpr qint32 RESPONSE_TIMEOUT_MS = 10000;
+constexpr qint32 PERSISTENT_PROTOCOL_VERSION = 2;
+
+static QString getRequestTypeName(const BuildMonitorRequestType type)
+{
+	switch (type)
+	{
+	case BuildMonitorRequestType::FixInformation:
+		return "fix_state";
+	case BuildMonitorRequestType::ReportFixing:
+		return "report_fixing";
+	case BuildMonitorRequestType::ReportFixed:
+		return "mark_fixed";
+	}
+
+	return QString();
+}
+
+static EFixMessageType getMessageType(const BuildMonitorRequestType type)
+{
+	switch (type)
+	{
+	case BuildMonitorRequestType::FixInformation:
+		return EFixMessageType::FixState;
+	case BuildMonitorRequestType::ReportFixing:
+		return EFixMessageType::ReportFixing;
+	case BuildMonitorRequestType::ReportFixed:
+		return EFixMessageType::MarkFixed;
+	}
+
+	return EFixMessageType::Error;
+}
+
+static QByteArray createLegacyRequest(const BuildMonitorServerWorker::Request& request)
+{
+	QJsonObject requestInfo;
+	switch (request.type)
+	{
+	case BuildMonitorRequestType::FixInformation:
+	{
+		QJsonArray projectsArray;
+		for (const QString& projectName : request.projectNames)
+		{
+			projectsArray.push_back(projectName);
+		}
+		requestInfo["projects"] = projectsArray;
+		break;
+	}
+	case BuildMonitorRequestType::ReportFixing:
+		requestInfo["project_name"] = request.projectName;
+		requestInfo["user_name"] = request.userName;
+		requestInfo["build_number"] = request.buildNumber;
+		break;
+	case BuildMonitorRequestType::ReportFixed:
+		requestInfo["project_name"] = request.projectName;
+		requestInfo["build_number"] = request.buildNumber;
+		break;
+	}
+
+	QJsonObject root;
+	root["version"] = 1;
+	root["request_type"] = getRequestTypeName(request.type);
+	root["request_info"] = requestInfo;
+	QJsonDocument doc;
+	doc.setObject(root);
+	return doc.toBinaryData();
+}
 
 BuildMonitorServerWorker::BuildMonitorServerWorker(QThread& workerThread) :
 	QObject(nullptr),
+	serverPort(0),
+	connectedPort(0),
 	socket(this),
+	connectionState(EConnectionState::Disconnected),
+	responseTimer(new QTimer(this)),
+	fixVersion(0),
+	nextRequestId(1),
 	isProcessingRequest(false)
 {
 	qRegisterMetaType<BuildMonitorRequestType>();
+	qRegisterMetaType<std::vector<FixInformation>>();
 
-	connect(&socket, &QIODevice::readyRead, this, &BuildMonitorServerWorker::onResponseGenerated);
+	connect(&socket, &QIODevice::readyRead, this, &BuildMonitorServerWorker::onReadyRead);
 	connect(&socket, &QAbstractSocket::disconnected, this, &BuildMonitorServerWorker::onDisconnected);
 
+	responseTimer->setSingleShot(true);
+	connect(responseTimer, &QTimer::timeout, this, &BuildMonitorServerWorker::onResponseTimeout);
+
 	moveToThread(&workerThread);
 }
 
@@ -52,6 +138,7 @@ void BuildMonitorServerWorker::addToQueue(const Request& request)
 {
 	requestMutex.lock();
 	requests.emplace_back(request);
+	requests.back().id = nextRequestId++;
 	requestMutex.unlock();
 }
 
@@ -67,44 +154,147 @@ bool BuildMonitorServerWorker::containsRequestType(const BuildMonitorRequestType
 
 void BuildMonitorServerWorker::processQueue()
 {
-	requestMutex.lock();
-	if (requests.empty() || isProcessingRequest)
+	connectMutex.lock();
+	const QString address = serverAddress;
+	const quint16 port = serverPort;
+	connectMutex.unlock();
+
+	if (address != connectedAddress || port != connectedPort)
 	{
+		// A different server might speak a different version, negotiate again.
+		connectionState = EConnectionState::Disconnected;
+		responseTimer->stop();
+		socket.abort();
+		reader.clear();
+		dictionary.clear();
+		fixVersion = 0;
+		fixInformation.clear();
+		connectedAddress = address;
+		connectedPort = port;
+		isProcessingRequest = false;
+
+		requestMutex.lock();
+		for (Request& request : requests)
+		{
+			request.isSent = false;
+		}
 		requestMutex.unlock();
-		return;
 	}
 
-	isProcessingRequest = true;
-	Request request = *requests.begin();
+	requestMutex.lock();
+	const bool hasRequests = !requests.empty();
 	requestMutex.unlock();
+	if (!hasRequests)
+	{
+		return;
+	}
 
-	connectMutex.lock();
+	switch (connectionState)
+	{
+	case EConnectionState::Disconnected:
+		connectToServer();
+		break;
+	case EConnectionState::Negotiating:
+		break;
+	case EConnectionState::Persistent:
+		sendPendingRequests();
+		break;
+	case EConnectionState::Legacy:
+		sendLegacyRequest();
+		break;
+	}
+}
+
+void BuildMonitorServerWorker::connectToServer()
+{
 	socket.abort();
-	socket.connectToHost(serverAddress, serverPort);
-	if (socket.waitForConnected(3000))
+	reader.clear();
+	dictionary.clear();
+	socket.connectToHost(connectedAddress, connectedPort);
+	if (!socket.waitForConnected(CONNECT_TIMEOUT_MS))
 	{
-		socket.write(request.data);
-		socket.flush();
-		socket.waitForBytesWritten();
-		connectMutex.unlock();
+		failNextRequest();
+		return;
 	}
-	else
+
+	// Sent as a version 1 request, servers that don't know it close the connection.
+	QJsonObject root;
+	root["version"] = 1;
+	root["request_type"] = "hello";
+	QJsonObject requestInfo;
+	requestInfo["version"] = PERSISTENT_PROTOCOL_VERSION;
+	root["request_info"] = requestInfo;
+	QJsonDocument doc;
+	doc.setObject(root);
+
+	connectionState = EConnectionState::Negotiating;
+	socket.setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+	socket.write(doc.toBinaryData());
+	responseTimer->start(RESPONSE_TIMEOUT_MS);
+}
+
+void BuildMonitorServerWorker::sendPendingRequests()
+{
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	requestMutex.lock();
+	for (Request& request : requests)
 	{
-		connectMutex.unlock();
-		onDisconnected();
+		if (!request.isSent)
+		{
+			FixMessageWriter writer(dictionary, request.id, getMessageType(request.type));
+			switch (request.type)
+			{
+			case BuildMonitorRequestType::FixInformation:
+				writer.writeUnsigned(fixVersion);
+				break;
+			case BuildMonitorRequestType::ReportFixing:
+				writer.writeString(request.projectName);
+				writer.writeString(request.userName);
+				writer.writeInteger(request.buildNumber);
+				break;
+			case BuildMonitorRequestType::ReportFixed:
+				writer.writeString(request.projectName);
+				writer.writeInteger(request.buildNumber);
+				break;
+			}
+
+			writeMessageFrame(socket, writer.getMessage());
+			request.sentTime = now;
+			request.isSent = true;
+		}
 	}
+	requestMutex.unlock();
+
+	scheduleResponseTimeout();
 }
 
-void BuildMonitorServerWorker::onResponseGenerated()
+void BuildMonitorServerWorker::sendLegacyRequest()
 {
-	QByteArray data = socket.readAll();
-	isProcessingRequest = false;
-	emit responseGenerated(data);
+	if (isProcessingRequest)
+	{
+		return;
+	}
+
+	requestMutex.lock();
+	const QByteArray data = createLegacyRequest(requests.front());
+	requestMutex.unlock();
+
+	socket.abort();
+	socket.connectToHost(connectedAddress, connectedPort);
+	if (socket.waitForConnected(CONNECT_TIMEOUT_MS))
+	{
+		isProcessingRequest = true;
+		socket.write(data);
+		responseTimer->start(RESPONSE_TIMEOUT_MS);
+	}
+	else
+	{
+		failNextRequest();
+	}
 }
 
-void BuildMonitorServerWorker::onDisconnected()
+void BuildMonitorServerWorker::failNextRequest()
 {
-	isProcessingRequest = false;
 	requestMutex.lock();
 	if (requests.size() > 0)
 	{
@@ -118,4 +308,305 @@ void BuildMonitorServerWorker::onDisconnected()
 	{
 		requestMutex.unlock();
 	}
-}
\ No newline at end of file
+}
+
+void BuildMonitorServerWorker::scheduleResponseTimeout()
+{
+	qint64 oldestSentTime = 0;
+	requestMutex.lock();
+	for (const Request& request : requests)
+	{
+		if (request.isSent && (oldestSentTime == 0 || request.sentTime < oldestSentTime))
+		{
+			oldestSentTime = request.sentTime;
+		}
+	}
+	requestMutex.unlock();
+
+	if (oldestSentTime == 0)
+	{
+		responseTimer->stop();
+		return;
+	}
+
+	const qint64 remainingTime = oldestSentTime + RESPONSE_TIMEOUT_MS - QDateTime::currentMSecsSinceEpoch();
+	responseTimer->start(static_cast<int>(std::max<qint64>(remainingTime, 0)));
+}
+
+void BuildMonitorServerWorker::onResponseTimeout()
+{
+	switch (connectionState)
+	{
+	case EConnectionState::Negotiating:
+		// Not the behavior of a version 1 server, which closes the connection. Try again with the next request.
+		connectionState = EConnectionState::Disconnected;
+		socket.abort();
+		reader.clear();
+		failNextRequest();
+		break;
+	case EConnectionState::Persistent:
+	{
+		requestMutex.lock();
+		const qint64 deadline = QDateTime::currentMSecsSinceEpoch() - RESPONSE_TIMEOUT_MS;
+		const bool isOverdue = std::find_if(requests.begin(), requests.end(),
+			[deadline](const Request& request) { return request.isSent && request.sentTime <= deadline; }) != requests.end();
+		requestMutex.unlock();
+
+		if (isOverdue)
+		{
+			socket.abort(); // Fails the requests in flight.
+		}
+		else
+		{
+			scheduleResponseTimeout();
+		}
+		break;
+	}
+	case EConnectionState::Legacy:
+		socket.abort(); // Fails the request in flight.
+		break;
+	case EConnectionState::Disconnected:
+		break;
+	}
+}
+
+void BuildMonitorServerWorker::onReadyRead()
+{
+	reader.readFrom(socket);
+
+	QByteArray message;
+	switch (connectionState)
+	{
+	case EConnectionState::Negotiating:
+		if (reader.nextUnframedMessage(message))
+		{
+			processHelloResponse(message);
+		}
+		break;
+	case EConnectionState::Persistent:
+		while (connectionState == EConnectionState::Persistent && reader.nextFrame(message))
+		{
+			processFrame(message);
+		}
+		break;
+	case EConnectionState::Legacy:
+		if (reader.nextUnframedMessage(message))
+		{
+			processLegacyResponse(message);
+		}
+		break;
+	case EConnectionState::Disconnected:
+		reader.clear();
+		break;
+	}
+
+	if (reader.hasError())
+	{
+		socket.abort();
+	}
+}
+
+void BuildMonitorServerWorker::onDisconnected()
+{
+	responseTimer->stop();
+
+	switch (connectionState)
+	{
+	case EConnectionState::Negotiating:
+		// The server only speaks version 1.
+		connectionState = EConnectionState::Legacy;
+		QMetaObject::invokeMethod(this, &BuildMonitorServerWorker::processQueue, Qt::QueuedConnection);
+		break;
+	case EConnectionState::Persistent:
+	{
+		// Requests that were in flight are lost, the ones that weren't sent yet go out on the next connection.
+		connectionState = EConnectionState::Disconnected;
+		reader.clear();
+
+		std::vector<BuildMonitorRequestType> failedTypes;
+		requestMutex.lock();
+		std::vector<Request>::iterator firstSent = std::stable_partition(requests.begin(), requests.end(),
+			[](const Request& request) { return !request.isSent; });
+		for (std::vector<Request>::iterator it = firstSent; it != requests.end(); ++it)
+		{
+			failedTypes.push_back(it->type);
+		}
+		requests.erase(firstSent, requests.end());
+		requestMutex.unlock();
+
+		for (const BuildMonitorRequestType type : failedTypes)
+		{
+			emit failure(type);
+		}
+		break;
+	}
+	case EConnectionState::Legacy:
+		if (isProcessingRequest)
+		{
+			isProcessingRequest = false;
+			failNextRequest();
+		}
+		break;
+	case EConnectionState::Disconnected:
+		break;
+	}
+}
+
+void BuildMonitorServerWorker::processHelloResponse(const QByteArray& message)
+{
+	const QJsonObject root = QJsonDocument::fromBinaryData(message).object();
+	if (root["response_type"].toString() == "hello" &&
+		root["response_info"].toObject()["version"].toInt() >= PERSISTENT_PROTOCOL_VERSION)
+	{
+		connectionState = EConnectionState::Persistent;
+		sendPendingRequests();
+	}
+	else
+	{
+		connectionState = EConnectionState::Legacy;
+		socket.abort();
+		reader.clear();
+		processQueue();
+	}
+}
+
+void BuildMonitorServerWorker::processFrame(const QByteArray& message)
+{
+	FixMessageReader messageReader(dictionary, message);
+	quint32 requestId = 0;
+	EFixMessageType messageType = EFixMessageType::Error;
+	bool isValid = messageReader.readHeader(requestId, messageType);
+	if (isValid && messageType == EFixMessageType::FixState)
+	{
+		isValid = applyFixChanges(messageReader);
+	}
+
+	if (!isValid || !messageReader.isAtEnd())
+	{
+		// The dictionaries are out of sync, the requests in flight fail with the connection. Changes might have
+		// been applied partially, so the full fix table is retrieved again.
+		fixVersion = 0;
+		socket.abort();
+		return;
+	}
+
+	requestMutex.lock();
+	std::vector<Request>::iterator pos = std::find_if(requests.begin(), requests.end(),
+		[requestId](const Request& element) { return element.isSent && element.id == requestId; });
+	if (pos == requests.end())
+	{
+		requestMutex.unlock();
+		return;
+	}
+
+	const BuildMonitorRequestType type = pos->type;
+	requests.erase(pos);
+	requestMutex.unlock();
+
+	scheduleResponseTimeout();
+
+	if (messageType == EFixMessageType::Error)
+	{
+		emit failure(type);
+	}
+	else
+	{
+		emit responseReceived(type, type == BuildMonitorRequestType::FixInformation ? fixInformation : std::vector<FixInformation>());
+	}
+}
+
+bool BuildMonitorServerWorker::applyFixChanges(FixMessageReader& messageReader)
+{
+	quint64 version = 0;
+	quint64 isFullState = 0;
+	quint32 startedCount = 0;
+	if (!messageReader.readUnsigned(version) || !messageReader.readUnsigned(isFullState) ||
+		!messageReader.readCount(startedCount))
+	{
+		return false;
+	}
+
+	if (isFullState)
+	{
+		fixInformation.clear();
+	}
+
+	for (quint32 i = 0; i < startedCount; ++i)
+	{
+		QString projectName;
+		QString userName;
+		qint32 buildNumber = 0;
+		if (!messageReader.readString(projectName) || !messageReader.readString(userName) ||
+			!messageReader.readInteger(buildNumber))
+		{
+			return false;
+		}
+
+		std::vector<FixInformation>::iterator pos = std::find_if(fixInformation.begin(), fixInformation.end(),
+			[&projectName](const FixInformation& element) { return element.projectName == projectName; });
+		if (pos != fixInformation.end())
+		{
+			*pos = FixInformation(projectName, userName, buildNumber);
+		}
+		else
+		{
+			fixInformation.emplace_back(projectName, userName, buildNumber);
+		}
+	}
+
+	quint32 finishedCount = 0;
+	if (!messageReader.readCount(finishedCount))
+	{
+		return false;
+	}
+
+	for (quint32 i = 0; i < finishedCount; ++i)
+	{
+		QString projectName;
+		if (!messageReader.readString(projectName))
+		{
+			return false;
+		}
+
+		fixInformation.erase(std::remove_if(fixInformation.begin(), fixInformation.end(),
+			[&projectName](const FixInformation& element) { return element.projectName == projectName; }), fixInformation.end());
+	}
+
+	fixVersion = version;
+	return true;
+}
+
+void BuildMonitorServerWorker::processLegacyResponse(const QByteArray& message)
+{
+	isProcessingRequest = false;
+	responseTimer->stop();
+
+	requestMutex.lock();
+	if (requests.empty())
+	{
+		requestMutex.unlock();
+		return;
+	}
+
+	const BuildMonitorRequestType type = requests.begin()->type;
+	requests.erase(requests.begin());
+	requestMutex.unlock();
+
+	std::vector<FixInformation> fixInformation;
+	const QJsonObject root = QJsonDocument::fromBinaryData(message).object();
+	if (root["version"].toInt() == 1 && root["response_type"].toString() == "fix_state")
+	{
+		const QJsonArray responseInfo = root["response_info"].toArray();
+		for (const QJsonValue& value : responseInfo)
+		{
+			const QJsonObject object = value.toObject();
+			fixInformation.emplace_back(
+				object["project_name"].toString(),
+				object["user_name"].toString(),
+				object["build_number"].toInt()
+			);
+		}
+	}
+
+	emit responseReceived(type, fixInformation);
+}
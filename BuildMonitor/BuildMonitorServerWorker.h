@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include "FixInformation.h"
+#include "FixMessage.h"
+#include "MessageFraming.h"
+
 #include <qmutex.h>
 #include <qobject.h>
 #include <qtcpsocket.h>
@@ -28,6 +32,8 @@ enum class BuildMonitorRequestType
 	ReportFixed
 };
 
+// Keeps a single connection to the fix server open, on which any number of requests can be in flight. Servers
+// that don't understand protocol version 2 get one connection per request instead, as in version 1.
 class BuildMonitorServerWorker : public QObject
 {
 	Q_OBJECT
@@ -35,14 +41,23 @@ class BuildMonitorServerWorker : public QObject
 public:
 	struct Request
 	{
-		Request(const QByteArray& inData, const BuildMonitorRequestType& inType) :
-			data(inData),
-			type(inType)
+		Request(const BuildMonitorRequestType& inType) :
+			type(inType),
+			buildNumber(0),
+			id(0),
+			sentTime(0),
+			isSent(false)
 		{
 		}
 
-		QByteArray data;
 		BuildMonitorRequestType type;
+		std::vector<QString> projectNames; // Only used to request fix information from version 1 servers.
+		QString projectName;
+		QString userName;
+		qint32 buildNumber;
+		quint32 id; // Matches the response to the request.
+		qint64 sentTime; // Milliseconds since the epoch.
+		bool isSent;
 	};
 
 	BuildMonitorServerWorker(QThread& workerThread);
@@ -57,22 +72,57 @@ public slots:
 	void processQueue();
 
 signals:
-	void responseGenerated(QByteArray data);
+	void responseReceived(BuildMonitorRequestType type, std::vector<FixInformation> fixInformation);
 	void failure(BuildMonitorRequestType type);
 
 private:
-	void onResponseGenerated();
+	enum class EConnectionState
+	{
+		Disconnected,
+		Negotiating,
+		Persistent,
+		Legacy
+	};
+
+	void connectToServer();
+	void sendPendingRequests();
+	void sendLegacyRequest();
+	void failNextRequest();
+	void scheduleResponseTimeout();
+	void onResponseTimeout();
+
+	void onReadyRead();
 	void onDisconnected();
+	void processHelloResponse(const QByteArray& message);
+	void processFrame(const QByteArray& message);
+	bool applyFixChanges(FixMessageReader& messageReader);
+	void processLegacyResponse(const QByteArray& message);
 
 	QMutex connectMutex;
 	QString serverAddress;
 	quint16 serverPort;
+
+	QString connectedAddress;
+	quint16 connectedPort;
 	QTcpSocket socket;
+	EConnectionState connectionState;
+	MessageFrameReader reader;
+	FixMessageDictionary dictionary;
+
+	// Connections that stop responding without being closed, for example because the server's host went away,
+	// are aborted once a response is overdue.
+	class QTimer* responseTimer;
+
+	// Fix table of the server as of the version, kept up to date with the changes since.
+	quint64 fixVersion;
+	std::vector<FixInformation> fixInformation;
 
 	QMutex requestMutex;
 	std::vector<Request> requests;
+	quint32 nextRequestId;
 
-	bool isProcessingRequest;
+	bool isProcessingRequest; // Only used for servers that only speak version 1.
 };
 
 Q_DECLARE_METATYPE(BuildMonitorRequestType);
+Q_DECLARE_METATYPE(std::vector<FixInformation>);
@@ -0,0 +1,94 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "DurationPredictor.h"
+
+#include <algorithm>
+
+// Below this number of builds the percentiles say little, the mean is used instead.
+constexpr qint32 MINIMUM_SAMPLES_FOR_PERCENTILES = 3;
+constexpr double EXPONENTIAL_MEAN_WEIGHT = 0.25; // Of the newest duration.
+
+DurationPredictor::ProjectStatistics::ProjectStatistics() :
+	count(0),
+	next(0),
+	exponentialMean(0.0)
+{
+}
+
+quint32 DurationPredictor::ProjectStatistics::getPercentile(qint32 percentile) const
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	const qint32 index = std::min(std::max(percentile, 0) * count / 100, count - 1);
+	return sortedDurations[index];
+}
+
+void DurationPredictor::addDuration(quint64 projectKey, quint32 duration)
+{
+	ProjectStatistics& statistics = projects[projectKey];
+	quint32* sortedBegin = statistics.sortedDurations;
+
+	// The oldest duration leaves the window, which is kept sorted by shifting instead of sorting again.
+	if (statistics.count == WINDOW_SIZE)
+	{
+		quint32* evicted = std::lower_bound(sortedBegin, sortedBegin + statistics.count, statistics.recentDurations[statistics.next]);
+		std::copy(evicted + 1, sortedBegin + statistics.count, evicted);
+		--statistics.count;
+	}
+
+	quint32* insertion = std::upper_bound(sortedBegin, sortedBegin + statistics.count, duration);
+	std::copy_backward(insertion, sortedBegin + statistics.count, sortedBegin + statistics.count + 1);
+	*insertion = duration;
+	++statistics.count;
+
+	statistics.recentDurations[statistics.next] = duration;
+	statistics.next = (statistics.next + 1) % WINDOW_SIZE;
+
+	statistics.exponentialMean = statistics.count == 1 ? duration :
+		statistics.exponentialMean + EXPONENTIAL_MEAN_WEIGHT * (duration - statistics.exponentialMean);
+}
+
+qint64 DurationPredictor::predictDuration(quint64 projectKey, qint64 inProgressFor) const
+{
+	const QHash<quint64, ProjectStatistics>::const_iterator statistics = projects.constFind(projectKey);
+	if (statistics == projects.constEnd() || statistics->count == 0)
+	{
+		return 0;
+	}
+
+	if (statistics->count < MINIMUM_SAMPLES_FOR_PERCENTILES)
+	{
+		return static_cast<qint64>(statistics->exponentialMean * 1000);
+	}
+
+	// The median isn't thrown off by the odd build that hung or was cut short.
+	const quint64 elapsed = static_cast<quint64>(std::max<qint64>(inProgressFor / 1000, 0));
+	const quint32 median = statistics->getPercentile(50);
+	if (elapsed < median)
+	{
+		return static_cast<qint64>(median) * 1000;
+	}
+
+	// Builds that depend on the node they run on repeat one of their earlier durations. Once a build outlasts
+	// the median the next longer duration that was seen is expected, instead of a build that is overdue.
+	const quint32* sortedEnd = statistics->sortedDurations + statistics->count;
+	const quint32* longer = std::upper_bound(static_cast<const quint32*>(statistics->sortedDurations), sortedEnd, elapsed);
+	return longer != sortedEnd ? static_cast<qint64>(*longer) * 1000 : 0;
+}
@@ -0,0 +1,50 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <qhash.h>
+
+// Predicts how long builds take from the durations of the last builds of the same project. Statistics are
+// updated for every finished build in constant time, they don't depend on the length of the history.
+class DurationPredictor
+{
+public:
+	// Projects are identified by their key, jobs of the same name on several servers are separate projects.
+	void addDuration(quint64 projectKey, quint32 duration); // In seconds.
+
+	// Duration in milliseconds of a build that has been running for the given time, 0 if there is nothing to
+	// base a prediction on.
+	qint64 predictDuration(quint64 projectKey, qint64 inProgressFor) const;
+
+private:
+	static constexpr qint32 WINDOW_SIZE = 32;
+
+	struct ProjectStatistics
+	{
+		ProjectStatistics();
+
+		quint32 getPercentile(qint32 percentile) const;
+
+		quint32 recentDurations[WINDOW_SIZE]; // In order of arrival, overwriting the oldest.
+		quint32 sortedDurations[WINDOW_SIZE]; // The same durations, kept sorted for the percentiles.
+		qint32 count;
+		qint32 next;
+		double exponentialMean;
+	};
+
+	QHash<quint64, ProjectStatistics> projects;
+};
@@ -13,7 +13,7 @@ if %errorlevel% neq 0 (
 rd /S /Q "%~dp0\Files\"
 mkdir "%~dp0\Files\"
 copy "%~dp0\..\release\BuildMonitor.exe" "%~dp0\Files\"
-"C:\Qt\5.9\msvc2017_64\bin\windeployqt.exe" "%~dp0\Files\BuildMonitor.exe"
+"C:\Qt\5.10\msvc2017_64\bin\windeployqt.exe" "%~dp0\Files\BuildMonitor.exe"
 if %errorlevel% neq 0 (
 	echo Failed to generate dependencies.
 	pause
@@ -16,45 +16,262 @@
  */
 
 #include "JenkinsCommunication.h"
+#include "JenkinsEventStream.h"
+#include "JenkinsParseWorker.h"
+#include "JenkinsRequestScheduler.h"
+#include "ProjectInformationCache.h"
 #include "Settings.h"
 
-#include <qjsonarray.h>
-#include <qjsondocument.h>
-#include <qjsonobject.h>
-#include <qnetworkaccessmanager.h>
 #include <qnetworkreply.h>
 #include <qnetworkrequest.h>
+#include <qrandomgenerator.h>
+#include <qthread.h>
 #include <qtimer.h>
+#include <qurlquery.h>
+
+#include <algorithm>
+
+// Everything displayed in the overview is retrieved with a single request per server. Servers that don't
+// honor the tree parameter return jobs without build information, those are retrieved per project instead.
+constexpr const char* JENKINS_JOBS_TREE = "jobs[name,url,color,"
+	"lastBuild[number,duration,timestamp,estimatedDuration,culprits[fullName]],"
+	"lastSuccessfulBuild[number,timestamp]]";
+
+// Once a server is known, only the state of its jobs is listed. Build information is then retrieved for
+// the projects that are new, changed or still building.
+constexpr const char* JENKINS_JOBS_LISTING_TREE = "jobs[name,url,color,lastBuild[number]]";
+constexpr const char* JENKINS_LAST_BUILD_TREE = "number,duration,timestamp,estimatedDuration,culprits[fullName]";
+constexpr const char* JENKINS_LAST_SUCCESSFUL_BUILD_TREE = "number,timestamp";
+
+constexpr int PUBLISH_DELAY_MS = 100;
+
+constexpr const char* PROJECT_CACHE_FILE_NAME = "ProjectCache.bin";
+constexpr const char* BUILD_HISTORY_FILE_NAME = "BuildHistory.bin";
+
+// The refresh interval setting is used while nothing happens on a server. Builds in progress are refreshed sooner,
+// at the latest when they are expected to finish. Refreshes that don't find any change back off, as do failures.
+constexpr qint64 MINIMUM_REFRESH_INTERVAL_MS = 5000;
+constexpr qint64 BUILDING_REFRESH_INTERVAL_MS = 15000;
+constexpr qint32 MAXIMUM_IDLE_INTERVAL_FACTOR = 4;
+constexpr qint32 MAXIMUM_FAILURE_INTERVAL_FACTOR = 8;
+constexpr qint32 REFRESH_JITTER_PERCENTAGE = 10; // Spreads the requests of all clients over time.
+
+// Refreshing while events are pushed only catches what the events may have missed.
+constexpr qint64 EVENT_STREAM_REFRESH_INTERVAL_MS = 600000;
+
+// Merges ranges that are sorted each into a single sorted sequence, instead of sorting all elements at once.
+template <typename Iterator, typename Less, typename Output>
+static void mergeSortedRanges(std::vector<std::pair<Iterator, Iterator> >& ranges, const Less& less, const Output& output)
+{
+	const auto greater = [&less](const std::pair<Iterator, Iterator>& lhs, const std::pair<Iterator, Iterator>& rhs)
+	{
+		return less(*rhs.first, *lhs.first);
+	};
+
+	ranges.erase(std::remove_if(ranges.begin(), ranges.end(),
+		[](const std::pair<Iterator, Iterator>& range) { return range.first == range.second; }), ranges.end());
+	std::make_heap(ranges.begin(), ranges.end(), greater);
+	while (!ranges.empty())
+	{
+		std::pop_heap(ranges.begin(), ranges.end(), greater);
+		std::pair<Iterator, Iterator>& range = ranges.back();
+		output(*range.first);
+		if (++range.first == range.second)
+		{
+			ranges.pop_back();
+		}
+		else
+		{
+			std::push_heap(ranges.begin(), ranges.end(), greater);
+		}
+	}
+}
+
+// Filters the stored projects of a server that is kept when the settings change.
+static void applyParseSettings(std::map<QString, ProjectInformation>& projects, const JenkinsParseSettings& parseSettings)
+{
+	// Projects that are shown now are added by the next listing.
+	for (std::map<QString, ProjectInformation>::iterator project = projects.begin(); project != projects.end();)
+	{
+		ProjectInformation& info = project->second;
+		if (!parseSettings.projectFilter.isShown(project->first) ||
+			(info.status == EProjectStatus::Disabled && !parseSettings.showDisabledProjects))
+		{
+			project = projects.erase(project);
+			continue;
+		}
+
+		for (qint32 i = info.initiatedBy.size() - 1; i >= 0; --i)
+		{
+			const QString& name = StringTable::get(info.initiatedBy[i]);
+			if (std::find(parseSettings.ignoreUserList.begin(), parseSettings.ignoreUserList.end(), name) != parseSettings.ignoreUserList.end())
+			{
+				info.initiatedBy.remove(i);
+			}
+		}
+		++project;
+	}
+}
+
+JenkinsCommunication::ServerState::ServerState() :
+	isKnown(false),
+	isStale(false),
+	isCached(false),
+	isRetrievalRequired(false),
+	isListingPending(false),
+	isRefreshRequested(false),
+	idleRefreshes(0),
+	failedRefreshes(0),
+	refreshFailed(false),
+	refreshFoundChanges(false),
+	refreshTimer(nullptr),
+	eventStream(nullptr)
+{
+}
 
 JenkinsCommunication::JenkinsCommunication(QObject* parent) :
 	QObject(parent),
-	networkAccessManager(new QNetworkAccessManager(this)),
-	refreshTimer(new QTimer(this)),
-	jenkinsServerRepliesCount(0),
-	projectRetrievalRepliesCount(0)
+	nextRetrievalId(0),
+	settings(nullptr),
+	requestScheduler(new JenkinsRequestScheduler(this)),
+	workerThread(new QThread(this)),
+	worker(new JenkinsParseWorker(*workerThread)),
+	publishTimer(new QTimer(this))
+{
+	qRegisterMetaType<ProjectSnapshot>();
+
+	// Projects are retrieved independently of each other, updates arriving close together are published at once.
+	publishTimer->setSingleShot(true);
+	publishTimer->setInterval(PUBLISH_DELAY_MS);
+	connect(publishTimer, &QTimer::timeout, this, &JenkinsCommunication::publishProjectInformation);
+
+	connect(worker, &JenkinsParseWorker::listingProcessed, this, &JenkinsCommunication::onListingProcessed);
+	connect(worker, &JenkinsParseWorker::projectProcessed, this, &JenkinsCommunication::onProjectProcessed);
+
+	workerThread->setObjectName("JenkinsParseThread");
+	workerThread->start();
+}
+
+JenkinsCommunication::~JenkinsCommunication()
 {
-	connect(refreshTimer, &QTimer::timeout, this, &JenkinsCommunication::refresh);
+	workerThread->quit();
+	workerThread->wait();
+	delete worker;
 }
 
 void JenkinsCommunication::setSettings(const Settings* inSettings)
 {
 	settings = inSettings;
+	buildHistory.open(settings->projectSettingsFolder.absoluteFilePath(BUILD_HISTORY_FILE_NAME));
 }
 
 void JenkinsCommunication::refreshSettings()
 {
-	int refreshInterval = settings->refreshIntervalInSeconds * 1000;
-	if (refreshTimer->interval() != refreshInterval)
+	const JenkinsParseSettings parseSettings(*settings);
+
+	// Users that aren't ignored anymore are missing from the stored builds, which are retrieved again for that.
+	const bool isRetrievalRequired = std::find_if(ignoreUserList.begin(), ignoreUserList.end(), [&parseSettings](const QString& name)
+	{
+		return std::find(parseSettings.ignoreUserList.begin(), parseSettings.ignoreUserList.end(), name) == parseSettings.ignoreUserList.end();
+	}) != ignoreUserList.end();
+	ignoreUserList = parseSettings.ignoreUserList;
+
+	std::map<QString, ServerState> lastServers = std::move(servers);
+	servers.clear();
+	for (const QUrl& serverURL : settings->serverURLs)
+	{
+		const QString server = serverURL.toString();
+		if (servers.find(server) != servers.end())
+		{
+			continue; // Configured twice.
+		}
+
+		// Servers that are kept keep their projects, listings that are underway and event stream.
+		const std::map<QString, ServerState>::iterator lastState = lastServers.find(server);
+		if (lastState != lastServers.end())
+		{
+			ServerState& state = servers[server];
+			state = std::move(lastState->second);
+			lastServers.erase(lastState);
+			applyParseSettings(state.projects, parseSettings);
+			state.isRetrievalRequired = state.isRetrievalRequired || isRetrievalRequired;
+			continue;
+		}
+
+		ServerState& state = servers[server];
+		state.url = serverURL;
+		state.refreshTimer = new QTimer(this);
+		state.refreshTimer->setSingleShot(true);
+		connect(state.refreshTimer, &QTimer::timeout, this, [this, server]() { refreshServer(server); });
+	}
+
+	for (std::pair<const QString, ServerState>& lastState : lastServers)
+	{
+		delete lastState.second.refreshTimer;
+		delete lastState.second.eventStream;
+
+		const QString server = lastState.first;
+		QMetaObject::invokeMethod(worker, [this, server]() { worker->removeServer(server); });
+	}
+
+	// Retrievals underway might be parsed with the previous settings, their projects are retrieved again by the
+	// next listing.
+	for (ProjectRetrieval& retrieval : projectRetrievals)
+	{
+		retrieval.isDiscarded = true;
+	}
+	requestScheduler->setMaximumRequestsPerHost(settings->maxRequestsPerServer);
+
+	QMetaObject::invokeMethod(worker, [this, parseSettings]() { worker->setParseSettings(parseSettings); });
+
+	startEventStreams();
+	schedulePublish();
+}
+
+void JenkinsCommunication::loadCachedProjectInformation()
+{
+	if (projectInformation.getGeneration() != 0)
 	{
-		if (refreshTimer->isActive())
+		return; // Already refreshed.
+	}
+
+	std::vector<ProjectInformation> projects;
+	if (!ProjectInformationCache::load(settings->projectSettingsFolder.absoluteFilePath(PROJECT_CACHE_FILE_NAME), projects, cachedAvailableProjects))
+	{
+		return;
+	}
+
+	// Every server keeps its cached projects until its own listing replaces them. Projects of servers that were
+	// removed from the settings since are dropped.
+	for (ProjectInformation& info : projects)
+	{
+		const std::map<QString, ServerState>::iterator state = servers.find(StringTable::get(info.server));
+		if (state != servers.end() && !state->second.isKnown)
 		{
-			refreshTimer->stop();
+			state->second.projects[info.getProjectName()] = std::move(info);
+			state->second.isCached = true;
 		}
-		refreshTimer->start(refreshInterval);
 	}
+
+	publishProjectInformation();
 }
 
-const std::vector<ProjectInformation>& JenkinsCommunication::getProjectInformation() const
+void JenkinsCommunication::saveCachedProjectInformation() const
+{
+	if (projectInformation.isStale() || projectInformation.getGeneration() == 0)
+	{
+		return; // Nothing new to store.
+	}
+
+	if (!settings->projectSettingsFolder.exists())
+	{
+		settings->projectSettingsFolder.mkpath(settings->projectSettingsFolder.absolutePath());
+	}
+	ProjectInformationCache::save(settings->projectSettingsFolder.absoluteFilePath(PROJECT_CACHE_FILE_NAME),
+		projectInformation.getProjects(), allAvailableProjects);
+}
+
+ProjectSnapshot JenkinsCommunication::getProjectInformation() const
 {
 	return projectInformation;
 }
@@ -64,274 +281,462 @@ const std::vector<QString>& JenkinsCommunication::getAllAvailableProjects() cons
 	return allAvailableProjects;
 }
 
+const BuildHistory& JenkinsCommunication::getBuildHistory() const
+{
+	return buildHistory;
+}
+
 void JenkinsCommunication::refresh()
 {
-	if (!jenkinsServerReplies.empty() && !projectRetrievalReplies.empty())
+	for (const std::pair<const QString, ServerState>& state : servers)
+	{
+		refreshServer(state.first);
+	}
+}
+
+void JenkinsCommunication::refreshServer(const QString& server)
+{
+	const std::map<QString, ServerState>::iterator state = servers.find(server);
+	if (state == servers.end() || isRefreshing(server, state->second))
 	{
 		return;
 	}
 
-	startJenkinsServerInformationRetrieval();
+	state->second.refreshTimer->stop();
+	state->second.isRefreshRequested = false;
+	state->second.refreshFailed = false;
+	state->second.refreshFoundChanges = false;
+	state->second.isListingPending = true;
+	startJenkinsServerInformationRetrieval(server, state->second);
 }
 
-void JenkinsCommunication::startJenkinsServerInformationRetrieval()
+void JenkinsCommunication::startJenkinsServerInformationRetrieval(const QString& server, const ServerState& state)
 {
-	jenkinsServerRepliesCount = 0;
-	jenkinsServerReplies.clear();
-	allAvailableProjects.clear();
-	projectInformation.clear();
-	for (QUrl jenkinsRequest : settings->serverURLs)
+	QUrl jenkinsRequest = state.url;
+	jenkinsRequest.setPath("/api/json");
+	QUrlQuery query;
+	query.addQueryItem("tree", state.isKnown ? JENKINS_JOBS_LISTING_TREE : JENKINS_JOBS_TREE);
+	jenkinsRequest.setQuery(query);
+	QNetworkRequest projectInformationRequest(jenkinsRequest);
+	projectInformationRequest.setHeader(QNetworkRequest::ServerHeader, "application/json");
+	worker->prepareListingRequest(projectInformationRequest);
+
+	// Listings can be several megabytes, they are parsed while being received.
+	requestScheduler->get(projectInformationRequest, EJenkinsRequestPriority::ServerListing, [this, server](QNetworkReply* reply)
 	{
-		jenkinsRequest.setPath("/api/json");
-		QNetworkRequest projectInformationRequest(jenkinsRequest);
-		projectInformationRequest.setHeader(QNetworkRequest::ServerHeader, "application/json");
-
-		jenkinsServerReplies.emplace_back(networkAccessManager->get(projectInformationRequest));
-		connect(jenkinsServerReplies.back(), &QNetworkReply::finished, this, &JenkinsCommunication::onJenkinsInformationReceived);
-	}
+		onJenkinsInformationReceived(server, reply);
+	},
+	[this, server](const QByteArray& data, bool isFirst)
+	{
+		QMetaObject::invokeMethod(worker, [this, server, data, isFirst]() { worker->parseListingData(server, data, isFirst); });
+	});
 }
 
-void JenkinsCommunication::startProjectInformationRetrieval()
+void JenkinsCommunication::startProjectInformationRetrieval(const QString& server, const ProjectInformation& info)
 {
-	projectRetrievalRepliesCount = 0;
-	if (projectInformation.empty())
+	projectRetrievals.push_back({ ++nextRetrievalId, server, info, 2 });
+	ProjectRetrieval* retrieval = &projectRetrievals.back();
+	const std::map<QString, ServerState>::iterator state = servers.find(server);
+	if (state != servers.end())
 	{
-		projectInformationUpdated(projectInformation);
+		state->second.refreshFoundChanges = true;
 	}
-	else
+
+	// Projects that need attention are shown first when a server has many projects to retrieve.
+	const EJenkinsRequestPriority priority = info.isBuilding || info.status == EProjectStatus::Failed ?
+		EJenkinsRequestPriority::ActiveProject : EJenkinsRequestPriority::IdleProject;
+
+	const QUrl projectUrl = info.getProjectUrl();
+	QUrl projectRequest = projectUrl;
+	projectRequest.setPath("/job/" + info.getProjectName() + "/lastBuild/api/json");
+	QUrlQuery query;
+	query.addQueryItem("tree", JENKINS_LAST_BUILD_TREE);
+	projectRequest.setQuery(query);
+	QNetworkRequest projectInformationRequest(projectRequest);
+	projectInformationRequest.setHeader(QNetworkRequest::ServerHeader, "application/json");
+	worker->prepareBuildRequest(projectInformationRequest);
+	requestScheduler->get(projectInformationRequest, priority, [this, retrieval](QNetworkReply* reply)
 	{
-		for (ProjectInformation& info : projectInformation)
+		// Jobs that never ran have no last build. Other failures keep the previous build information.
+		if (reply->error() != QNetworkReply::NoError && reply->error() != QNetworkReply::ContentNotFoundError)
 		{
-			QUrl projectRequest = info.projectUrl;
-			projectRequest.setPath("/job/" + info.projectName + "/lastBuild/api/json");
-			QNetworkRequest projectInformationRequest(projectRequest);
-			projectInformationRequest.setHeader(QNetworkRequest::ServerHeader, "application/json");
-			projectRetrievalReplies.emplace_back(&info, networkAccessManager->get(projectInformationRequest));
-			connect(projectRetrievalReplies.back().second, &QNetworkReply::finished, this, &JenkinsCommunication::onProjectInformationReceived);
+			projectInformationError("Failed to retrieve " + retrieval->info.getProjectName() + ": " + reply->errorString());
 		}
+		retrieval->lastBuildReply = JenkinsReply(reply);
+		onProjectReplyReceived(retrieval);
+	});
+
+	QUrl lastSuccessfulRequest = projectUrl;
+	lastSuccessfulRequest.setPath("/job/" + info.getProjectName() + "/lastSuccessfulBuild/api/json");
+	QUrlQuery lastSuccessfulQuery;
+	lastSuccessfulQuery.addQueryItem("tree", JENKINS_LAST_SUCCESSFUL_BUILD_TREE);
+	lastSuccessfulRequest.setQuery(lastSuccessfulQuery);
+	QNetworkRequest lastSuccessfulInformationRequest(lastSuccessfulRequest);
+	lastSuccessfulInformationRequest.setHeader(QNetworkRequest::ServerHeader, "application/json");
+	worker->prepareBuildRequest(lastSuccessfulInformationRequest);
+	requestScheduler->get(lastSuccessfulInformationRequest, priority, [this, retrieval](QNetworkReply* reply)
+	{
+		retrieval->lastSuccessfulBuildReply = JenkinsReply(reply);
+		onProjectReplyReceived(retrieval);
+	});
+}
+
+void JenkinsCommunication::onJenkinsInformationReceived(const QString& server, QNetworkReply* reply)
+{
+	if (reply->error() != QNetworkReply::NoError)
+	{
+		onJenkinsServerFailed(server, reply->errorString());
+		return;
 	}
+
+	const JenkinsReply jenkinsReply(reply);
+	QMetaObject::invokeMethod(worker, [this, server, jenkinsReply]() { worker->processListing(server, jenkinsReply); });
 }
 
-void JenkinsCommunication::startLastSuccesfulProjectInformationRetrieval()
+void JenkinsCommunication::onJenkinsServerFailed(const QString& server, const QString& errorMessage)
 {
-	projectRetrievalRepliesCount = 0;
-	if (projectInformation.empty())
+	const std::map<QString, ServerState>::iterator state = servers.find(server);
+	if (state == servers.end())
 	{
-		projectInformationUpdated(projectInformation);
+		return; // Removed from the settings meanwhile.
 	}
-	else
+
+	// The last known projects keep being shown, marked stale, until the server can be reached again.
+	state->second.isListingPending = false;
+	state->second.isStale = true;
+	state->second.isCached = false;
+	state->second.refreshFailed = true;
+	schedulePublish();
+	projectInformationError(errorMessage);
+	finishRefresh(server);
+}
+
+void JenkinsCommunication::onListingProcessed(const JenkinsListing& listing)
+{
+	const std::map<QString, ServerState>::iterator state = servers.find(listing.server);
+	if (state == servers.end())
+	{
+		return;
+	}
+
+	if (!listing.succeeded)
 	{
-		for (ProjectInformation& info : projectInformation)
+		onJenkinsServerFailed(listing.server, "Invalid response from " + listing.server);
+		return;
+	}
+
+	ServerState& serverState = state->second;
+	serverState.isListingPending = false;
+	serverState.isKnown = true;
+	serverState.isStale = false;
+	serverState.isCached = false;
+	serverState.allProjects = listing.allProjects;
+	std::sort(serverState.allProjects.begin(), serverState.allProjects.end());
+
+	// Projects that are being retrieved keep showing their previous information until their retrieval finishes.
+	const std::map<QString, ProjectInformation> lastServerProjects = std::move(serverState.projects);
+	std::map<QString, ProjectInformation>& serverProjects = serverState.projects;
+	serverProjects.clear();
+
+	for (const JenkinsListedProject& project : listing.projects)
+	{
+		const ProjectInformation& info = project.info;
+		if (project.hasBuildInformation)
 		{
-			QUrl projectRequest = info.projectUrl;
-			projectRequest.setPath("/job/" + info.projectName + "/lastSuccessfulBuild/api/json");
-			QNetworkRequest projectInformationRequest(projectRequest);
-			projectInformationRequest.setHeader(QNetworkRequest::ServerHeader, "application/json");
-			projectRetrievalReplies.emplace_back(&info, networkAccessManager->get(projectInformationRequest));
-			connect(projectRetrievalReplies.back().second, &QNetworkReply::finished, this, &JenkinsCommunication::onLastSuccesfulProjectInformationReceived);
+			commitProject(serverProjects, info);
+			continue;
 		}
+
+		const std::map<QString, ProjectInformation>::const_iterator lastInfo = lastServerProjects.find(info.getProjectName());
+		if (lastInfo == lastServerProjects.end())
+		{
+			startProjectInformationRetrieval(listing.server, info);
+			continue;
+		}
+
+		serverProjects[info.getProjectName()] = lastInfo->second;
+		if (!serverState.isRetrievalRequired && !info.isBuilding && !lastInfo->second.isBuilding &&
+			lastInfo->second.status == info.status && lastInfo->second.buildNumber == project.lastBuildNumber)
+		{
+			continue;
+		}
+
+		// Build information that fails to be retrieved keeps its previous value instead of being reset.
+		ProjectInformation retrievalInfo = lastInfo->second;
+		retrievalInfo.projectPath = info.projectPath;
+		retrievalInfo.status = info.status;
+		retrievalInfo.isBuilding = info.isBuilding;
+		startProjectInformationRetrieval(listing.server, retrievalInfo);
 	}
+
+	serverState.isRetrievalRequired = false;
+
+	if (serverProjects.size() != lastServerProjects.size())
+	{
+		serverState.refreshFoundChanges = true;
+	}
+
+	schedulePublish();
+	finishRefresh(listing.server);
 }
 
-void JenkinsCommunication::onJenkinsInformationReceived()
+void JenkinsCommunication::onProjectReplyReceived(ProjectRetrieval* retrieval)
 {
-	++jenkinsServerRepliesCount;
-	if (jenkinsServerRepliesCount != jenkinsServerReplies.size())
+	if (--retrieval->pendingReplies != 0)
 	{
-		return; // We are still awaiting response from other jenkins servers.
+		return; // Still awaiting the other request of this project.
 	}
 
-	for (QNetworkReply* reply : jenkinsServerReplies)
+	const quint64 retrievalId = retrieval->id;
+	const ProjectInformation info = retrieval->info;
+	const JenkinsReply lastBuildReply = retrieval->lastBuildReply;
+	const JenkinsReply lastSuccessfulBuildReply = retrieval->lastSuccessfulBuildReply;
+	QMetaObject::invokeMethod(worker, [this, retrievalId, info, lastBuildReply, lastSuccessfulBuildReply]()
 	{
-		if (reply->error() == QNetworkReply::NoError)
+		worker->processProject(retrievalId, info, lastBuildReply, lastSuccessfulBuildReply);
+	});
+}
+
+void JenkinsCommunication::onProjectProcessed(const JenkinsProjectResult& result)
+{
+	const std::list<ProjectRetrieval>::iterator retrieval = std::find_if(projectRetrievals.begin(), projectRetrievals.end(),
+		[&result](const ProjectRetrieval& element) { return element.id == result.retrievalId; });
+	if (retrieval == projectRetrievals.end())
+	{
+		return;
+	}
+
+	const QString server = retrieval->server;
+	const std::map<QString, ServerState>::iterator state = servers.find(server);
+	if (state != servers.end() && !retrieval->isDiscarded)
+	{
+		commitProject(state->second.projects, result.info);
+		schedulePublish();
+	}
+
+	projectRetrievals.erase(retrieval);
+	finishRefresh(server);
+}
+
+void JenkinsCommunication::commitProject(std::map<QString, ProjectInformation>& serverProjects, ProjectInformation info)
+{
+	buildHistory.record(info);
+
+	// Jenkins estimates the average of the last builds, which is far off for projects of which the duration
+	// depends on the node they run on. Falls back to it while there is no history.
+	if (info.isBuilding)
+	{
+		const qint64 predictedDuration = buildHistory.getDurationPredictor().predictDuration(info.getKey(), info.inProgressFor);
+		if (predictedDuration != 0)
 		{
-			QJsonDocument document(QJsonDocument::fromJson(reply->readAll()));
-			QJsonObject root = document.object();
-			QJsonArray projects = root["jobs"].toArray();
+			info.estimatedDuration = predictedDuration;
+			info.estimatedRemainingTime = predictedDuration - info.inProgressFor;
+		}
+	}
 
-			for (const QJsonValue& project : projects)
-			{
-				if (project.isObject())
-				{
-					const QJsonObject object = project.toObject();
-					ProjectInformation info;
-					info.projectName = object["name"].toString();
-
-					allAvailableProjects.emplace_back(info.projectName);
-
-					if (settings->useRegExProjectFilter)
-					{
-						if (!settings->projectIncludeRegEx.exactMatch(info.projectName) ||
-							settings->projectExcludeRegEx.exactMatch(info.projectName))
-						{
-							continue;
-						}
-					}
-					else
-					{
-						if (std::find(settings->enabledProjectList.begin(),
-								settings->enabledProjectList.end(), info.projectName) ==
-									settings->enabledProjectList.end())
-						{
-							continue;
-						}
-					}
-
-					info.projectUrl = object["url"].toString();
-					if (info.projectUrl.host() != reply->url().host())
-					{
-						info.projectUrl.setHost(reply->url().host());
-					}
-					bool addToList = true;
-					const QString buildStatus = object["color"].toString();
-					if (buildStatus.startsWith("blue"))
-					{
-						info.status = EProjectStatus::Succeeded;
-					}
-					else if (buildStatus.startsWith("red"))
-					{
-						info.status = EProjectStatus::Failed;
-					}
-					else if (buildStatus.startsWith("yellow"))
-					{
-						info.status = EProjectStatus::Unstable;
-					}
-					else if (buildStatus.startsWith("disabled"))
-					{
-						addToList = settings->showDisabledProjects;
-						info.status = EProjectStatus::Disabled;
-					}
-					else if (buildStatus.startsWith("aborted"))
-					{
-						info.status = EProjectStatus::Aborted;
-					}
-					else if (buildStatus.startsWith("notbuilt"))
-					{
-						info.status = EProjectStatus::NotBuilt;
-					}
-					else
-					{
-						info.status = EProjectStatus::Unknown;
-					}
-					info.isBuilding = buildStatus.endsWith("_anime");
-
-					if (addToList)
-					{
-						projectInformation.emplace_back(info);
-					}
-				}
-			}
+	serverProjects[info.getProjectName()] = info;
+}
+
+void JenkinsCommunication::startEventStreams()
+{
+	for (std::pair<const QString, ServerState>& state : servers)
+	{
+		if (!settings->usePushUpdates)
+		{
+			delete state.second.eventStream;
+			state.second.eventStream = nullptr;
+			continue;
 		}
-		else
+
+		if (state.second.eventStream != nullptr)
 		{
-			projectInformationError(reply->errorString());
+			continue; // Kept along with its server.
 		}
+
+		const QString server = state.first;
+		JenkinsEventStream* eventStream = new JenkinsEventStream(state.second.url, this);
+		// Run events don't carry the state of the job, the listing retrieves it along with the builds that changed.
+		// Events may have been missed while not connected, a refresh catches up on those.
+		const auto refreshEventServer = [this, server]() { requestRefresh(server); };
+		connect(eventStream, &JenkinsEventStream::jobBuildChanged, this, refreshEventServer);
+		connect(eventStream, &JenkinsEventStream::jobListChanged, this, refreshEventServer);
+		connect(eventStream, &JenkinsEventStream::connected, this, refreshEventServer);
+		connect(eventStream, &JenkinsEventStream::disconnected, this, refreshEventServer);
+		eventStream->start();
+		state.second.eventStream = eventStream;
+	}
+}
+
+void JenkinsCommunication::requestRefresh(const QString& server)
+{
+	const std::map<QString, ServerState>::iterator state = servers.find(server);
+	if (state == servers.end())
+	{
+		return;
 	}
 
-	for (QNetworkReply* reply : jenkinsServerReplies)
+	if (isRefreshing(server, state->second))
 	{
-		delete reply;
+		// The listing might predate the event, so the server is refreshed again once done.
+		state->second.isRefreshRequested = true;
+		return;
 	}
-	jenkinsServerReplies.clear();
 
-	startProjectInformationRetrieval();
+	refreshServer(server);
 }
 
-void JenkinsCommunication::onProjectInformationReceived()
+bool JenkinsCommunication::isRefreshing(const QString& server, const ServerState& state) const
 {
-	++projectRetrievalRepliesCount;
-	if (projectRetrievalRepliesCount != projectRetrievalReplies.size())
+	return state.isListingPending || std::any_of(projectRetrievals.begin(), projectRetrievals.end(),
+		[&server](const ProjectRetrieval& retrieval) { return retrieval.server == server; });
+}
+
+void JenkinsCommunication::finishRefresh(const QString& server)
+{
+	const std::map<QString, ServerState>::iterator state = servers.find(server);
+	if (state == servers.end() || isRefreshing(server, state->second) || state->second.refreshTimer->isActive())
 	{
-		return; // Still in the process of receiving projects.
+		return; // Busy, or already scheduled.
 	}
 
-	for (std::pair<ProjectInformation*, QNetworkReply*>& pair : projectRetrievalReplies)
+	ServerState& serverState = state->second;
+	serverState.failedRefreshes = serverState.refreshFailed ? serverState.failedRefreshes + 1 : 0;
+	serverState.idleRefreshes = serverState.refreshFoundChanges ? 0 : serverState.idleRefreshes + 1;
+
+	// Stored after every change as well as on exit, in case the application isn't exited normally.
+	if (serverState.refreshFoundChanges && !serverState.refreshFailed)
 	{
-		QNetworkReply* reply = pair.second;
-		if (reply->error() == QNetworkReply::NoError)
+		if (publishTimer->isActive())
 		{
-			const QJsonDocument document(QJsonDocument::fromJson(reply->readAll()));
-			QJsonObject root = document.object();
+			publishTimer->stop();
+			publishProjectInformation();
+		}
+		saveCachedProjectInformation();
+	}
 
-			ProjectInformation& info = *pair.first;
-			if (root["duration"].toDouble() != 0)
-			{
-				info.inProgressFor = root["duration"].toDouble();
-				info.estimatedRemainingTime = 0;
-			}
-			else
-			{
-				const qint64 timestamp = root["timestamp"].toDouble();
-				const qint64 currentTime = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
-				info.inProgressFor = currentTime - timestamp;
-				info.estimatedRemainingTime = root["estimatedDuration"].toDouble() - info.inProgressFor;
-			}
+	// Servers that were reset by a change of the settings or received events while busy are retrieved again
+	// right away.
+	const bool isReset = !serverState.isKnown && !serverState.refreshFailed;
+	const bool isRefreshRequested = serverState.isRefreshRequested;
+	serverState.isRefreshRequested = false;
+	serverState.refreshTimer->start(isReset || isRefreshRequested ? 0 : calculateRefreshInterval(serverState));
+}
 
-			info.buildNumber = root["number"].toInt();
+qint32 JenkinsCommunication::calculateRefreshInterval(const ServerState& state) const
+{
+	const qint64 refreshInterval = settings->refreshIntervalInSeconds * 1000;
+	qint64 interval = refreshInterval;
 
-			const QJsonArray culprits = root["culprits"].toArray();
-			for (const QJsonValue culprit : culprits)
+	if (state.failedRefreshes != 0)
+	{
+		interval = refreshInterval * std::min(1 << std::min(state.failedRefreshes, 16), MAXIMUM_FAILURE_INTERVAL_FACTOR);
+	}
+	else if (state.eventStream != nullptr && state.eventStream->isConnected())
+	{
+		interval = std::max(refreshInterval, EVENT_STREAM_REFRESH_INTERVAL_MS);
+	}
+	else
+	{
+		bool isBuilding = false;
+		qint64 nextExpectedCompletion = BUILDING_REFRESH_INTERVAL_MS;
+		for (const std::pair<const QString, ProjectInformation>& project : state.projects)
+		{
+			if (project.second.isBuilding)
 			{
-				if (culprit.isObject())
+				isBuilding = true;
+				if (project.second.estimatedRemainingTime > 0)
 				{
-					const QString name = culprit.toObject()["fullName"].toString();
-					if (std::find(settings->ignoreUserList.begin(), settings->ignoreUserList.end(), name) == settings->ignoreUserList.end())
-					{
-						info.initiatedBy.emplace_back(name);
-					}
+					nextExpectedCompletion = std::min(nextExpectedCompletion, project.second.estimatedRemainingTime);
 				}
 			}
-			std::sort(info.initiatedBy.begin(), info.initiatedBy.end());
+		}
+
+		if (isBuilding)
+		{
+			interval = std::min(refreshInterval, std::max(MINIMUM_REFRESH_INTERVAL_MS, nextExpectedCompletion));
 		}
 		else
 		{
-			// TODO: Send error to status bar.
-			qDebug() << reply->errorString();
+			interval = refreshInterval * std::min(1 + state.idleRefreshes / 2, MAXIMUM_IDLE_INTERVAL_FACTOR);
 		}
 	}
 
-	for (std::pair<ProjectInformation*, class QNetworkReply*>& pair : projectRetrievalReplies)
-	{
-		delete pair.second;
-	}
-	projectRetrievalReplies.clear();
+	const qint64 jitter = interval * REFRESH_JITTER_PERCENTAGE / 100;
+	interval += QRandomGenerator::global()->bounded(static_cast<int>(2 * jitter + 1)) - jitter;
 
-	std::sort(projectInformation.begin(), projectInformation.end(), [](const ProjectInformation& lhs, const ProjectInformation& rhs)
-	{
-		return lhs.projectName < rhs.projectName;
-	});
-
-	std::sort(allAvailableProjects.begin(), allAvailableProjects.end());
-
-	startLastSuccesfulProjectInformationRetrieval();
+	return static_cast<qint32>(std::max(MINIMUM_REFRESH_INTERVAL_MS, interval));
 }
 
-void JenkinsCommunication::onLastSuccesfulProjectInformationReceived()
+void JenkinsCommunication::schedulePublish()
 {
-	++projectRetrievalRepliesCount;
-	if (projectRetrievalRepliesCount != projectRetrievalReplies.size())
+	if (!publishTimer->isActive())
 	{
-		return; // Still in the process of receiving projects.
+		publishTimer->start();
 	}
+}
 
-	for (std::pair<ProjectInformation*, QNetworkReply*>& pair : projectRetrievalReplies)
+void JenkinsCommunication::publishProjectInformation()
+{
+	typedef std::map<QString, ProjectInformation>::const_iterator ProjectIterator;
+	typedef std::vector<QString>::const_iterator NameIterator;
+
+	// The projects of every server are sorted by name already. Jobs of the same name on several servers are ordered
+	// by their server, so that every snapshot has the same order.
+	std::vector<std::pair<ProjectIterator, ProjectIterator> > projectRanges;
+	std::vector<std::pair<NameIterator, NameIterator> > availableProjectRanges;
+	std::vector<StringId> staleServers;
+	size_t projectCount = 0;
+	size_t availableProjectCount = 0;
+	std::vector<StringId> cachedServers;
+	for (const std::pair<const QString, ServerState>& state : servers)
 	{
-		QNetworkReply* reply = pair.second;
-		if (reply->error() == QNetworkReply::NoError)
+		projectRanges.emplace_back(state.second.projects.begin(), state.second.projects.end());
+		availableProjectRanges.emplace_back(state.second.allProjects.begin(), state.second.allProjects.end());
+		projectCount += state.second.projects.size();
+		availableProjectCount += state.second.allProjects.size();
+		if (state.second.isStale)
 		{
-			QJsonObject root = QJsonDocument::fromJson(reply->readAll()).object();
-			if (root["timestamp"].isDouble())
-			{
-				pair.first->lastSuccessfulBuildTime = root["timestamp"].toDouble();
-			}
+			staleServers.push_back(StringTable::intern(state.first));
+		}
+		if (state.second.isCached)
+		{
+			cachedServers.push_back(StringTable::intern(state.first));
 		}
 	}
+	const bool isCached = !cachedServers.empty();
 
-	for (std::pair<ProjectInformation*, class QNetworkReply*>& pair : projectRetrievalReplies)
+	// The available projects of the last session aren't known per server, they are offered until every server
+	// listed its own.
+	if (isCached)
+	{
+		availableProjectRanges.emplace_back(cachedAvailableProjects.begin(), cachedAvailableProjects.end());
+		availableProjectCount += cachedAvailableProjects.size();
+	}
+	else
+	{
+		cachedAvailableProjects.clear();
+	}
+
+	const auto projectLess = [](const std::pair<const QString, ProjectInformation>& lhs, const std::pair<const QString, ProjectInformation>& rhs)
+	{
+		return lhs.first < rhs.first ||
+			(lhs.first == rhs.first && StringTable::get(lhs.second.server) < StringTable::get(rhs.second.server));
+	};
+
+	std::vector<ProjectInformation> projects;
+	projects.reserve(projectCount);
+	mergeSortedRanges(projectRanges, projectLess,
+		[&projects](const std::pair<const QString, ProjectInformation>& project) { projects.emplace_back(project.second); });
+
+	allAvailableProjects.clear();
+	allAvailableProjects.reserve(availableProjectCount);
+	mergeSortedRanges(availableProjectRanges, std::less<QString>(),
+		[this](const QString& project) { allAvailableProjects.emplace_back(project); });
+	if (isCached)
 	{
-		delete pair.second;
+		allAvailableProjects.erase(std::unique(allAvailableProjects.begin(), allAvailableProjects.end()), allAvailableProjects.end());
 	}
-	projectRetrievalReplies.clear();
 
+	projectInformation = ProjectSnapshot(std::move(projects), projectInformation.getGeneration() + 1, std::move(staleServers), std::move(cachedServers));
 	projectInformationUpdated(projectInformation);
 }
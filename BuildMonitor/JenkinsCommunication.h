@@ -17,48 +17,122 @@
 
 #pragma once
 
+#include "BuildHistory.h"
+#include "JenkinsResponseCache.h"
 #include "ProjectInformation.h"
+#include "ProjectSnapshot.h"
 
 #include <qobject.h>
 #include <qurl.h>
 
+#include <list>
+#include <map>
+#include <vector>
+
 class JenkinsCommunication : public QObject
 {
 	Q_OBJECT
 
 public:
 	JenkinsCommunication(QObject* parent);
+	virtual ~JenkinsCommunication();
 
 	void setSettings(const class Settings* settings);
 	void refreshSettings();
+
+	// Publishes the projects of the last session as stale, until the first refresh of their server replaces them.
+	void loadCachedProjectInformation();
+	void saveCachedProjectInformation() const;
 	
-	const std::vector<ProjectInformation>& getProjectInformation() const;
+	ProjectSnapshot getProjectInformation() const;
 	const std::vector<QString>& getAllAvailableProjects() const;
+	const BuildHistory& getBuildHistory() const;
 
+	// Refreshes every server that isn't being refreshed already.
 	void refresh();
 
 Q_SIGNALS:
-	void projectInformationUpdated(const std::vector<ProjectInformation>& projectInformation);
+	void projectInformationUpdated(const ProjectSnapshot& projectInformation);
 	void projectInformationError(const QString& errorMessage);
 
 private:
-	void startJenkinsServerInformationRetrieval();
-	void startProjectInformationRetrieval();
-	void startLastSuccesfulProjectInformationRetrieval();
-
-	void onJenkinsInformationReceived();
-	void onProjectInformationReceived();
-	void onLastSuccesfulProjectInformationReceived();
-
-	std::vector<ProjectInformation> projectInformation;
+	// Build information of a single project that is being retrieved. The project is updated in the
+	// overview once all of its requests are finished.
+	struct ProjectRetrieval
+	{
+		quint64 id;
+		QString server;
+		ProjectInformation info;
+		size_t pendingReplies;
+		JenkinsReply lastBuildReply;
+		JenkinsReply lastSuccessfulBuildReply;
+		bool isDiscarded; // Started before the settings changed.
+	};
+
+	// Servers are refreshed and published independently of each other, so a slow or unreachable server
+	// doesn't hold up the others. The projects of a server that can't be reached are kept and marked stale.
+	struct ServerState
+	{
+		ServerState();
+
+		QUrl url;
+		bool isKnown; // Retrieved before, only the state of its jobs is listed.
+		bool isStale;
+		bool isCached; // Shows the projects of the last session until the server answers.
+		bool isRetrievalRequired; // The stored build information predates the settings.
+		bool isListingPending;
+		bool isRefreshRequested; // An event was received while refreshing.
+
+		// Information of the last refresh keyed by project name, used to only retrieve the build information
+		// of projects that changed since.
+		std::map<QString, ProjectInformation> projects;
+		std::vector<QString> allProjects; // Sorted.
+
+		// Refreshes in a row that didn't find any change or failed, used to back off.
+		qint32 idleRefreshes;
+		qint32 failedRefreshes;
+		bool refreshFailed;
+		bool refreshFoundChanges;
+
+		class QTimer* refreshTimer;
+
+		// Servers that push their events are refreshed when a job changes, and otherwise only polled once in a
+		// while until their stream is lost.
+		class JenkinsEventStream* eventStream;
+	};
+
+	void refreshServer(const QString& server);
+	void startJenkinsServerInformationRetrieval(const QString& server, const ServerState& state);
+	void startProjectInformationRetrieval(const QString& server, const ProjectInformation& info);
+
+	void onJenkinsInformationReceived(const QString& server, class QNetworkReply* reply);
+	void onJenkinsServerFailed(const QString& server, const QString& errorMessage);
+	void onListingProcessed(const struct JenkinsListing& listing);
+	void onProjectReplyReceived(ProjectRetrieval* retrieval);
+	void onProjectProcessed(const struct JenkinsProjectResult& result);
+	void commitProject(std::map<QString, ProjectInformation>& serverProjects, ProjectInformation info);
+	void startEventStreams();
+	void requestRefresh(const QString& server);
+	bool isRefreshing(const QString& server, const ServerState& state) const;
+	void finishRefresh(const QString& server);
+	qint32 calculateRefreshInterval(const ServerState& state) const;
+	void schedulePublish();
+	void publishProjectInformation();
+
+	ProjectSnapshot projectInformation;
 	std::vector<QString> allAvailableProjects;
+	std::vector<QString> cachedAvailableProjects; // Of the last session, until every server answered.
+	std::vector<QString> ignoreUserList; // As applied to the stored projects.
+	BuildHistory buildHistory;
+
+	std::map<QString, ServerState> servers; // Keyed by the server URL as configured.
+	std::list<ProjectRetrieval> projectRetrievals;
+	quint64 nextRetrievalId;
 
 	const class Settings* settings;
 
-	class QNetworkAccessManager* networkAccessManager;
-	class QTimer* refreshTimer;
-	std::vector<class QNetworkReply*> jenkinsServerReplies;
-	std::vector<std::pair<ProjectInformation*, class QNetworkReply*> > projectRetrievalReplies;
-	size_t jenkinsServerRepliesCount;
-	size_t projectRetrievalRepliesCount;
+	class JenkinsRequestScheduler* requestScheduler;
+	class QThread* workerThread;
+	class JenkinsParseWorker* worker;
+	class QTimer* publishTimer;
 };
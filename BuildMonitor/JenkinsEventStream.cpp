@@ -0,0 +1,277 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "JenkinsEventStream.h"
+
+#include <qjsonarray.h>
+#include <qjsondocument.h>
+#include <qjsonobject.h>
+#include <qnetworkaccessmanager.h>
+#include <qnetworkreply.h>
+#include <qnetworkrequest.h>
+#include <qtimer.h>
+#include <qurlquery.h>
+#include <quuid.h>
+
+#include <algorithm>
+
+constexpr qint32 RECONNECT_DELAY_MS = 1000; // Doubled for every failed connection in a row.
+constexpr qint32 MAXIMUM_RECONNECT_DELAY_MS = 60000;
+constexpr qint32 DEFAULT_IDLE_TIMEOUT_MS = 2 * 60 * 1000;
+
+// Events of builds and of the job list, other events of the job channel such as queue changes are ignored.
+constexpr const char* JENKINS_JOB_CHANNEL = "job";
+constexpr const char* JENKINS_RUN_STARTED_EVENT = "job_run_started";
+constexpr const char* JENKINS_RUN_ENDED_EVENT = "job_run_ended";
+constexpr const char* JENKINS_JOB_EVENT_PREFIX = "job_crud_";
+
+JenkinsEventStream::JenkinsEventStream(const QUrl& inServerURL, QObject* parent) :
+	QObject(parent),
+	serverURL(inServerURL),
+	clientId(QUuid::createUuid().toString().mid(1, 36)),
+	nextBatchId(0),
+	networkAccessManager(new QNetworkAccessManager(this)), // Holds the session cookie the gateway relies on.
+	connectReply(nullptr),
+	streamReply(nullptr),
+	reconnectTimer(new QTimer(this)),
+	idleTimer(new QTimer(this)),
+	failedConnections(0),
+	isStreamConnected(false)
+{
+	reconnectTimer->setSingleShot(true);
+	connect(reconnectTimer, &QTimer::timeout, this, &JenkinsEventStream::connectToServer);
+
+	idleTimer->setSingleShot(true);
+	idleTimer->setInterval(DEFAULT_IDLE_TIMEOUT_MS);
+	connect(idleTimer, &QTimer::timeout, this, &JenkinsEventStream::onIdleTimeout);
+}
+
+JenkinsEventStream::~JenkinsEventStream()
+{
+	if (connectReply != nullptr)
+	{
+		connectReply->disconnect(this);
+		connectReply->abort();
+	}
+	if (streamReply != nullptr)
+	{
+		streamReply->disconnect(this);
+		streamReply->abort();
+	}
+}
+
+void JenkinsEventStream::start()
+{
+	connectToServer();
+}
+
+bool JenkinsEventStream::isConnected() const
+{
+	return isStreamConnected;
+}
+
+void JenkinsEventStream::setIdleTimeout(qint32 timeout)
+{
+	idleTimer->setInterval(timeout);
+}
+
+void JenkinsEventStream::connectToServer()
+{
+	QUrl connectRequest = serverURL;
+	connectRequest.setPath("/sse-gateway/connect");
+	QUrlQuery query;
+	query.addQueryItem("clientId", clientId);
+	connectRequest.setQuery(query);
+
+	QNetworkReply* reply = networkAccessManager->get(QNetworkRequest(connectRequest));
+	connect(reply, &QNetworkReply::finished, this, [this, reply]() { onConnectFinished(reply); });
+	connectReply = reply;
+	idleTimer->start();
+}
+
+void JenkinsEventStream::onConnectFinished(QNetworkReply* reply)
+{
+	reply->deleteLater();
+	connectReply = nullptr;
+	if (reply->error() != QNetworkReply::NoError)
+	{
+		idleTimer->stop();
+		scheduleReconnect();
+		return;
+	}
+
+	QUrl listenRequest = serverURL;
+	listenRequest.setPath("/sse-gateway/listen/" + clientId);
+	QNetworkRequest request(listenRequest);
+	request.setRawHeader("Accept", "text/event-stream");
+
+	lineBuffer.clear();
+	eventType.clear();
+	eventData.clear();
+	streamReply = networkAccessManager->get(request);
+	connect(streamReply, &QNetworkReply::readyRead, this, &JenkinsEventStream::onStreamDataReceived);
+	connect(streamReply, &QNetworkReply::finished, this, &JenkinsEventStream::onStreamFinished);
+	idleTimer->start();
+}
+
+void JenkinsEventStream::onStreamDataReceived()
+{
+	idleTimer->start();
+	lineBuffer += streamReply->readAll();
+
+	int lineStart = 0;
+	for (int lineEnd = lineBuffer.indexOf('\n'); lineEnd != -1; lineEnd = lineBuffer.indexOf('\n', lineStart))
+	{
+		QByteArray line = lineBuffer.mid(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+		if (line.endsWith('\r'))
+		{
+			line.chop(1);
+		}
+
+		if (line.isEmpty())
+		{
+			dispatchEvent();
+			continue;
+		}
+
+		const int separator = line.indexOf(':');
+		if (separator == 0)
+		{
+			continue; // Comment, used to keep the connection alive.
+		}
+
+		const QByteArray field = separator == -1 ? line : line.left(separator);
+		QByteArray value = separator == -1 ? QByteArray() : line.mid(separator + 1);
+		if (value.startsWith(' '))
+		{
+			value.remove(0, 1);
+		}
+
+		if (field == "event")
+		{
+			eventType = value;
+		}
+		else if (field == "data")
+		{
+			if (!eventData.isEmpty())
+			{
+				eventData += '\n';
+			}
+			eventData += value;
+		}
+	}
+	lineBuffer.remove(0, lineStart);
+}
+
+void JenkinsEventStream::onStreamFinished()
+{
+	idleTimer->stop();
+	streamReply->deleteLater();
+	streamReply = nullptr;
+
+	if (isStreamConnected)
+	{
+		isStreamConnected = false;
+		disconnected();
+	}
+	scheduleReconnect();
+}
+
+void JenkinsEventStream::subscribe(const QString& dispatcherId)
+{
+	QUrl configureRequest = serverURL;
+	configureRequest.setPath("/sse-gateway/configure");
+	QUrlQuery query;
+	query.addQueryItem("batchId", QString::number(++nextBatchId));
+	configureRequest.setQuery(query);
+	QNetworkRequest request(configureRequest);
+	request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+	QJsonObject subscription;
+	subscription.insert("jenkins_channel", JENKINS_JOB_CHANNEL);
+	QJsonObject configuration;
+	configuration.insert("dispatcherId", dispatcherId);
+	configuration.insert("subscribe", QJsonArray({ subscription }));
+	configuration.insert("unsubscribe", QJsonArray());
+
+	QNetworkReply* reply = networkAccessManager->post(request, QJsonDocument(configuration).toJson(QJsonDocument::Compact));
+	connect(reply, &QNetworkReply::finished, this, [this, reply]()
+	{
+		reply->deleteLater();
+		if (reply->error() != QNetworkReply::NoError)
+		{
+			// Without a subscription no events arrive, start over.
+			if (streamReply != nullptr)
+			{
+				streamReply->abort();
+			}
+			return;
+		}
+
+		failedConnections = 0;
+		isStreamConnected = true;
+		connected();
+	});
+}
+
+void JenkinsEventStream::dispatchEvent()
+{
+	const QByteArray type = eventType;
+	const QJsonObject data = QJsonDocument::fromJson(eventData).object();
+	eventType.clear();
+	eventData.clear();
+
+	if (type == "open")
+	{
+		subscribe(data.value("dispatcherId").toString());
+		return;
+	}
+
+	if (data.value("jenkins_channel").toString() != JENKINS_JOB_CHANNEL)
+	{
+		return;
+	}
+
+	const QString event = data.value("jenkins_event").toString();
+	if (event == JENKINS_RUN_STARTED_EVENT || event == JENKINS_RUN_ENDED_EVENT)
+	{
+		jobBuildChanged(data.value("job_name").toString());
+	}
+	else if (event.startsWith(JENKINS_JOB_EVENT_PREFIX))
+	{
+		jobListChanged();
+	}
+}
+
+void JenkinsEventStream::scheduleReconnect()
+{
+	reconnectTimer->start(std::min(RECONNECT_DELAY_MS << std::min(failedConnections, 16), MAXIMUM_RECONNECT_DELAY_MS));
+	++failedConnections;
+}
+
+void JenkinsEventStream::onIdleTimeout()
+{
+	// Aborting finishes the request, which reconnects. The owner polls again while the stream is lost.
+	if (connectReply != nullptr)
+	{
+		connectReply->abort();
+	}
+	else if (streamReply != nullptr)
+	{
+		streamReply->abort();
+	}
+}
@@ -0,0 +1,77 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <qbytearray.h>
+#include <qobject.h>
+#include <qurl.h>
+
+// Receives the job events pushed by the SSE Gateway plugin of a Jenkins server, so changes are noticed as
+// they happen instead of by polling. A lost stream is reconnected with a backoff. The gateway keeps the stream
+// alive with comments, a stream on which nothing arrives for a while was dropped silently and is lost as well.
+class JenkinsEventStream : public QObject
+{
+	Q_OBJECT
+
+public:
+	JenkinsEventStream(const QUrl& serverURL, QObject* parent);
+	virtual ~JenkinsEventStream();
+
+	void start();
+
+	bool isConnected() const;
+
+	// Time in milliseconds without any data after which the stream is considered lost.
+	void setIdleTimeout(qint32 timeout);
+
+Q_SIGNALS:
+	void connected();
+	void disconnected();
+
+	// A build of the job started or ended.
+	void jobBuildChanged(const QString& jobName);
+
+	// Jobs were created, deleted or renamed.
+	void jobListChanged();
+
+private:
+	void connectToServer();
+	void onConnectFinished(class QNetworkReply* reply);
+	void onStreamDataReceived();
+	void onStreamFinished();
+	void subscribe(const QString& dispatcherId);
+	void dispatchEvent();
+	void scheduleReconnect();
+	void onIdleTimeout();
+
+	QUrl serverURL;
+	QString clientId;
+	qint32 nextBatchId;
+
+	class QNetworkAccessManager* networkAccessManager;
+	class QNetworkReply* connectReply;
+	class QNetworkReply* streamReply;
+	class QTimer* reconnectTimer;
+	class QTimer* idleTimer; // Restarted whenever data arrives.
+	qint32 failedConnections;
+	bool isStreamConnected;
+
+	// Event being received, the stream is line based and events end with an empty line.
+	QByteArray lineBuffer;
+	QByteArray eventType;
+	QByteArray eventData;
+};
@@ -0,0 +1,56 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <qstring.h>
+
+#include <vector>
+
+// Build as reported by Jenkins, before any of the settings are applied.
+struct JenkinsBuildInformation
+{
+	JenkinsBuildInformation() :
+		number(0),
+		duration(0),
+		timestamp(0),
+		estimatedDuration(0)
+	{
+	}
+
+	qint32 number; // Jenkins starts numbering at 1, 0 means there is no such build.
+	qint64 duration;
+	qint64 timestamp;
+	qint64 estimatedDuration;
+	std::vector<QString> culprits;
+};
+
+// Job entry of a server listing, before any of the settings are applied.
+struct JenkinsJobInformation
+{
+	JenkinsJobInformation() :
+		hasBuildInformation(false)
+	{
+	}
+
+	QString name;
+	QString url;
+	QString color;
+	bool hasBuildInformation; // The listing contained the complete last build and last successful build.
+	JenkinsBuildInformation lastBuild;
+	JenkinsBuildInformation lastSuccessfulBuild;
+};
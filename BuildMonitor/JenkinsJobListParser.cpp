@@ -0,0 +1,339 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JenkinsJobListParser.h"
+
+JenkinsJobListParser::JenkinsJobListParser()
+{
+	reset();
+}
+
+void JenkinsJobListParser::reset()
+{
+	buffer.clear();
+	position = 0;
+	expectingKey = false;
+	isFinished = false;
+	hasError = false;
+	scopes.clear();
+	job = JenkinsJobInformation();
+	build = nullptr;
+	jobs.clear();
+}
+
+void JenkinsJobListParser::parse(const QByteArray& data)
+{
+	if (hasError)
+	{
+		return;
+	}
+
+	buffer.append(data);
+	while (parseToken())
+	{
+	}
+
+	// Only an incomplete token remains, which is finished by the next data.
+	buffer.remove(0, position);
+	position = 0;
+}
+
+bool JenkinsJobListParser::finish()
+{
+	// A number or literal at the end of the data isn't terminated by anything.
+	parse(" ");
+	return !hasError && isFinished && position == buffer.size();
+}
+
+std::vector<JenkinsJobInformation> JenkinsJobListParser::takeJobs()
+{
+	std::vector<JenkinsJobInformation> completedJobs;
+	completedJobs.swap(jobs);
+	return completedJobs;
+}
+
+bool JenkinsJobListParser::parseToken()
+{
+	while (position < buffer.size() && (buffer[position] == ' ' || buffer[position] == '\n' ||
+		buffer[position] == '\r' || buffer[position] == '\t'))
+	{
+		++position;
+	}
+
+	if (hasError || position == buffer.size())
+	{
+		return false;
+	}
+
+	if (isFinished)
+	{
+		hasError = true; // Anything but whitespace after the root value.
+		return false;
+	}
+
+	switch (buffer[position])
+	{
+	case '{':
+	case '[':
+		beginContainer(buffer[position++] == '{');
+		return true;
+
+	case '}':
+	case ']':
+		endContainer(buffer[position++] == '}');
+		return true;
+
+	case ':':
+		++position;
+		expectingKey = false;
+		return true;
+
+	case ',':
+		++position;
+		expectingKey = !scopes.empty() && scopes.back().isObject;
+		return true;
+
+	case '"':
+	{
+		QString value;
+		if (!parseString(value))
+		{
+			return false;
+		}
+
+		if (expectingKey && !scopes.empty())
+		{
+			Scope& scope = scopes.back();
+			scope.key = value;
+			if (scope.type == EScope::Job && value == "lastSuccessfulBuild")
+			{
+				job.hasBuildInformation = true;
+			}
+		}
+		else
+		{
+			setString(value);
+		}
+		return true;
+	}
+
+	default:
+	{
+		QByteArray value;
+		if (!parseScalar(value))
+		{
+			return false;
+		}
+
+		setScalar(value);
+		return true;
+	}
+	}
+}
+
+bool JenkinsJobListParser::parseString(QString& value)
+{
+	// The string is only decoded once it is complete, so multi-byte characters are never split.
+	int end = position + 1;
+	while (end < buffer.size() && buffer[end] != '"')
+	{
+		end += buffer[end] == '\\' ? 2 : 1;
+	}
+	if (end >= buffer.size())
+	{
+		return false;
+	}
+
+	int start = position + 1;
+	for (int i = start; i < end; ++i)
+	{
+		if (buffer[i] != '\\')
+		{
+			continue;
+		}
+
+		value += QString::fromUtf8(buffer.constData() + start, i - start);
+		const char escaped = buffer[i + 1];
+		switch (escaped)
+		{
+		case 'b': value += QChar('\b'); break;
+		case 'f': value += QChar('\f'); break;
+		case 'n': value += QChar('\n'); break;
+		case 'r': value += QChar('\r'); break;
+		case 't': value += QChar('\t'); break;
+		case 'u':
+		{
+			bool isValid = false;
+			const ushort character = buffer.mid(i + 2, 4).toUShort(&isValid, 16);
+			if (!isValid || i + 6 > end)
+			{
+				hasError = true;
+				return false;
+			}
+			value += QChar(character); // Surrogate pairs are escaped as two characters, which is what QString expects.
+			i += 4;
+			break;
+		}
+		default: value += QChar(escaped); break;
+		}
+		++i;
+		start = i + 1;
+	}
+	value += QString::fromUtf8(buffer.constData() + start, end - start);
+
+	position = end + 1;
+	return true;
+}
+
+bool JenkinsJobListParser::parseScalar(QByteArray& value)
+{
+	int end = position;
+	while (end < buffer.size())
+	{
+		const char character = buffer[end];
+		if (character == ',' || character == '}' || character == ']' || character == ' ' ||
+			character == '\n' || character == '\r' || character == '\t')
+		{
+			break;
+		}
+		++end;
+	}
+	if (end == buffer.size())
+	{
+		return false;
+	}
+
+	value = buffer.mid(position, end - position);
+	position = end;
+	return true;
+}
+
+void JenkinsJobListParser::beginContainer(bool isObject)
+{
+	EScope type = EScope::Ignored;
+	if (scopes.empty())
+	{
+		type = isObject ? EScope::Root : EScope::Ignored;
+	}
+	else
+	{
+		const Scope& parent = scopes.back();
+		if (parent.type == EScope::Root && parent.key == "jobs" && !isObject)
+		{
+			type = EScope::Jobs;
+		}
+		else if (parent.type == EScope::Jobs && isObject)
+		{
+			type = EScope::Job;
+			job = JenkinsJobInformation();
+		}
+		else if (parent.type == EScope::Job && isObject && (parent.key == "lastBuild" || parent.key == "lastSuccessfulBuild"))
+		{
+			type = EScope::Build;
+			build = parent.key == "lastBuild" ? &job.lastBuild : &job.lastSuccessfulBuild;
+		}
+		else if (parent.type == EScope::Build && parent.key == "culprits" && !isObject)
+		{
+			type = EScope::Culprits;
+		}
+		else if (parent.type == EScope::Culprits && isObject)
+		{
+			type = EScope::Culprit;
+		}
+	}
+
+	scopes.push_back({ type, isObject, QString() });
+	expectingKey = isObject;
+}
+
+void JenkinsJobListParser::endContainer(bool isObject)
+{
+	if (scopes.empty() || scopes.back().isObject != isObject)
+	{
+		hasError = true;
+		return;
+	}
+
+	if (scopes.back().type == EScope::Job)
+	{
+		jobs.emplace_back(job);
+	}
+
+	scopes.pop_back();
+	expectingKey = false;
+	isFinished = scopes.empty();
+}
+
+void JenkinsJobListParser::setString(const QString& value)
+{
+	if (scopes.empty())
+	{
+		isFinished = true;
+		return;
+	}
+
+	const Scope& scope = scopes.back();
+	if (scope.type == EScope::Job)
+	{
+		if (scope.key == "name")
+		{
+			job.name = value;
+		}
+		else if (scope.key == "url")
+		{
+			job.url = value;
+		}
+		else if (scope.key == "color")
+		{
+			job.color = value;
+		}
+	}
+	else if (scope.type == EScope::Culprit && scope.key == "fullName")
+	{
+		build->culprits.emplace_back(value);
+	}
+}
+
+void JenkinsJobListParser::setScalar(const QByteArray& value)
+{
+	if (scopes.empty())
+	{
+		isFinished = true;
+		return;
+	}
+
+	const Scope& scope = scopes.back();
+	if (scope.type == EScope::Build)
+	{
+		if (scope.key == "number")
+		{
+			build->number = value.toInt();
+		}
+		else if (scope.key == "duration")
+		{
+			build->duration = value.toDouble();
+		}
+		else if (scope.key == "timestamp")
+		{
+			build->timestamp = value.toDouble();
+		}
+		else if (scope.key == "estimatedDuration")
+		{
+			build->estimatedDuration = value.toDouble();
+		}
+	}
+}
@@ -0,0 +1,77 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "JenkinsJobInformation.h"
+
+#include <qbytearray.h>
+
+// Extracts the jobs from a Jenkins server listing while it is being received, without building a document
+// of the whole response. Data can be passed in chunks of any size, values not needed are skipped.
+class JenkinsJobListParser
+{
+public:
+	JenkinsJobListParser();
+
+	void reset();
+	void parse(const QByteArray& data);
+
+	// Returns whether the complete response was received and understood.
+	bool finish();
+
+	// Jobs of which the closing brace was parsed.
+	std::vector<JenkinsJobInformation> takeJobs();
+
+private:
+	enum class EScope
+	{
+		Root,
+		Jobs,
+		Job,
+		Build,
+		Culprits,
+		Culprit,
+		Ignored
+	};
+
+	struct Scope
+	{
+		EScope type;
+		bool isObject;
+		QString key;
+	};
+
+	bool parseToken();
+	bool parseString(QString& value);
+	bool parseScalar(QByteArray& value);
+	void beginContainer(bool isObject);
+	void endContainer(bool isObject);
+	void setString(const QString& value);
+	void setScalar(const QByteArray& value);
+
+	QByteArray buffer;
+	int position;
+	bool expectingKey;
+	bool isFinished;
+	bool hasError;
+
+	std::vector<Scope> scopes;
+	JenkinsJobInformation job;
+	JenkinsBuildInformation* build;
+	std::vector<JenkinsJobInformation> jobs;
+};
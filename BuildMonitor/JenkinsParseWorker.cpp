@@ -0,0 +1,320 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JenkinsParseWorker.h"
+#include "Settings.h"
+
+#include <qdatetime.h>
+#include <qjsonarray.h>
+#include <qjsondocument.h>
+#include <qjsonobject.h>
+#include <qset.h>
+#include <qthread.h>
+
+JenkinsParseSettings::JenkinsParseSettings() :
+	showDisabledProjects(false)
+{
+}
+
+JenkinsParseSettings::JenkinsParseSettings(const Settings& settings) :
+	projectFilter(settings),
+	showDisabledProjects(settings.showDisabledProjects),
+	ignoreUserList(settings.ignoreUserList)
+{
+}
+
+JenkinsParseWorker::JenkinsParseWorker(QThread& workerThread) :
+	QObject(nullptr)
+{
+	qRegisterMetaType<JenkinsListing>();
+	qRegisterMetaType<JenkinsProjectResult>();
+
+	moveToThread(&workerThread);
+}
+
+void JenkinsParseWorker::prepareListingRequest(QNetworkRequest& request)
+{
+	cacheMutex.lock();
+	jobListCache.prepareRequest(request);
+	cacheMutex.unlock();
+}
+
+void JenkinsParseWorker::prepareBuildRequest(QNetworkRequest& request)
+{
+	cacheMutex.lock();
+	buildCache.prepareRequest(request);
+	cacheMutex.unlock();
+}
+
+void JenkinsParseWorker::setParseSettings(const JenkinsParseSettings& inSettings)
+{
+	settings = inSettings;
+}
+
+void JenkinsParseWorker::parseListingData(const QString& server, const QByteArray& data, bool isFirst)
+{
+	JenkinsJobListParser& parser = listingParsers[server];
+	if (isFirst)
+	{
+		parser.reset();
+	}
+	parser.parse(data);
+}
+
+void JenkinsParseWorker::processListing(const QString& server, const JenkinsReply& reply)
+{
+	JenkinsListing listing;
+	listing.server = server;
+	listing.succeeded = false;
+
+	// The caches are only modified on this thread, reading them doesn't need the mutex.
+	const std::vector<JenkinsJobInformation>* jobs = nullptr;
+	std::vector<JenkinsJobInformation> parsedJobs;
+	if (reply.isNotModified)
+	{
+		jobs = jobListCache.find(reply);
+	}
+	else
+	{
+		JenkinsJobListParser& parser = listingParsers[server];
+		if (parser.finish())
+		{
+			parsedJobs = parser.takeJobs();
+			cacheMutex.lock();
+			jobListCache.store(reply, parsedJobs);
+			cacheMutex.unlock();
+			pruneBuildCache(reply.url, parsedJobs);
+			jobs = &parsedJobs;
+		}
+	}
+	listingParsers.remove(server);
+
+	if (!reply.succeeded || jobs == nullptr)
+	{
+		listingProcessed(listing);
+		return;
+	}
+
+	listing.succeeded = true;
+	listing.allProjects.reserve(jobs->size());
+	const StringId server = StringTable::intern(listing.server);
+	for (const JenkinsJobInformation& job : *jobs)
+	{
+		listing.allProjects.emplace_back(job.name);
+
+		if (!settings.projectFilter.isShown(job.name))
+		{
+			continue;
+		}
+
+		JenkinsListedProject project;
+		ProjectInformation& info = project.info;
+		info.projectName = StringTable::intern(job.name);
+		info.server = server;
+		info.projectPath = StringTable::intern(QUrl(job.url).path());
+		bool addToList = true;
+		const QString& buildStatus = job.color;
+		if (buildStatus.startsWith("blue"))
+		{
+			info.status = EProjectStatus::Succeeded;
+		}
+		else if (buildStatus.startsWith("red"))
+		{
+			info.status = EProjectStatus::Failed;
+		}
+		else if (buildStatus.startsWith("yellow"))
+		{
+			info.status = EProjectStatus::Unstable;
+		}
+		else if (buildStatus.startsWith("disabled"))
+		{
+			addToList = settings.showDisabledProjects;
+			info.status = EProjectStatus::Disabled;
+		}
+		else if (buildStatus.startsWith("aborted"))
+		{
+			info.status = EProjectStatus::Aborted;
+		}
+		else if (buildStatus.startsWith("notbuilt"))
+		{
+			info.status = EProjectStatus::NotBuilt;
+		}
+		else
+		{
+			info.status = EProjectStatus::Unknown;
+		}
+		info.isBuilding = buildStatus.endsWith("_anime");
+
+		if (!addToList)
+		{
+			continue;
+		}
+
+		project.hasBuildInformation = job.hasBuildInformation;
+		project.lastBuildNumber = job.lastBuild.number;
+		if (job.hasBuildInformation)
+		{
+			applyLastBuild(job.lastBuild, info);
+			applyLastSuccessfulBuild(job.lastSuccessfulBuild, info);
+		}
+
+		listing.projects.emplace_back(project);
+	}
+
+	listingProcessed(listing);
+}
+
+void JenkinsParseWorker::processProject(quint64 retrievalId, ProjectInformation info, const JenkinsReply& lastBuildReply,
+	const JenkinsReply& lastSuccessfulBuildReply)
+{
+	JenkinsBuildInformation parsedBuild;
+	if (lastBuildReply.succeeded)
+	{
+		if (const JenkinsBuildInformation* build = findBuild(lastBuildReply, parsedBuild))
+		{
+			applyLastBuild(*build, info);
+		}
+	}
+
+	if (lastSuccessfulBuildReply.succeeded)
+	{
+		if (const JenkinsBuildInformation* build = findBuild(lastSuccessfulBuildReply, parsedBuild))
+		{
+			applyLastSuccessfulBuild(*build, info);
+		}
+	}
+
+	projectProcessed({ retrievalId, info });
+}
+
+void JenkinsParseWorker::removeServer(const QString& server)
+{
+	// Entries of another server on the same host are removed as well, which only costs a full transfer.
+	const QUrl serverURL(server);
+	const auto isRemoved = [&serverURL](const QUrl& url) { return isOnServer(url, serverURL); };
+	listingParsers.remove(server);
+	cacheMutex.lock();
+	jobListCache.removeIf(isRemoved);
+	buildCache.removeIf(isRemoved);
+	cacheMutex.unlock();
+}
+
+const JenkinsBuildInformation* JenkinsParseWorker::findBuild(const JenkinsReply& reply, JenkinsBuildInformation& parsedBuild)
+{
+	if (reply.isNotModified)
+	{
+		return buildCache.find(reply);
+	}
+
+	parsedBuild = parseBuild(QJsonDocument::fromJson(reply.body).object());
+	cacheMutex.lock();
+	buildCache.store(reply, parsedBuild);
+	cacheMutex.unlock();
+	return &parsedBuild;
+}
+
+void JenkinsParseWorker::pruneBuildCache(const QUrl& serverURL, const std::vector<JenkinsJobInformation>& jobs)
+{
+	// Builds of jobs that were deleted or renamed are never requested again.
+	QSet<QString> jobNames;
+	jobNames.reserve(static_cast<int>(jobs.size()));
+	for (const JenkinsJobInformation& job : jobs)
+	{
+		jobNames.insert(job.name);
+	}
+
+	cacheMutex.lock();
+	buildCache.removeIf([&serverURL, &jobNames](const QUrl& url)
+	{
+		return isOnServer(url, serverURL) && !jobNames.contains(url.path(QUrl::FullyDecoded).section('/', 2, 2)); // "/job/<name>/..."
+	});
+	cacheMutex.unlock();
+}
+
+bool JenkinsParseWorker::isOnServer(const QUrl& url, const QUrl& serverURL)
+{
+	return url.scheme() == serverURL.scheme() && url.host() == serverURL.host() && url.port() == serverURL.port();
+}
+
+JenkinsBuildInformation JenkinsParseWorker::parseBuild(const QJsonObject& object)
+{
+	JenkinsBuildInformation build;
+	build.number = object["number"].toInt();
+	build.duration = object["duration"].toDouble();
+	build.timestamp = object["timestamp"].toDouble();
+	build.estimatedDuration = object["estimatedDuration"].toDouble();
+
+	const QJsonArray culprits = object["culprits"].toArray();
+	for (const QJsonValue culprit : culprits)
+	{
+		if (culprit.isObject())
+		{
+			build.culprits.emplace_back(culprit.toObject()["fullName"].toString());
+		}
+	}
+
+	return build;
+}
+
+void JenkinsParseWorker::applyLastBuild(const JenkinsBuildInformation& build, ProjectInformation& info) const
+{
+	if (build.number == 0)
+	{
+		return;
+	}
+
+	if (build.duration != 0)
+	{
+		info.inProgressFor = build.duration;
+		info.estimatedRemainingTime = 0;
+		info.estimatedDuration = 0;
+	}
+	else
+	{
+		const qint64 currentTime = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+		info.inProgressFor = currentTime - build.timestamp;
+		info.estimatedRemainingTime = build.estimatedDuration - info.inProgressFor;
+		info.estimatedDuration = build.estimatedDuration;
+	}
+	info.buildStartTime = build.timestamp;
+
+	info.buildNumber = build.number;
+
+	std::vector<QString> initiatedBy;
+	for (const QString& name : build.culprits)
+	{
+		if (std::find(settings.ignoreUserList.begin(), settings.ignoreUserList.end(), name) == settings.ignoreUserList.end())
+		{
+			initiatedBy.emplace_back(name);
+		}
+	}
+	std::sort(initiatedBy.begin(), initiatedBy.end());
+
+	info.initiatedBy.clear();
+	for (const QString& name : initiatedBy)
+	{
+		info.initiatedBy.append(StringTable::intern(name));
+	}
+}
+
+void JenkinsParseWorker::applyLastSuccessfulBuild(const JenkinsBuildInformation& build, ProjectInformation& info) const
+{
+	if (build.number != 0)
+	{
+		info.lastSuccessfulBuildTime = build.timestamp;
+	}
+}
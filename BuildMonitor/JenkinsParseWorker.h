@@ -0,0 +1,106 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "JenkinsJobInformation.h"
+#include "JenkinsJobListParser.h"
+#include "JenkinsResponseCache.h"
+#include "ProjectFilter.h"
+#include "ProjectInformation.h"
+
+#include <qhash.h>
+#include <qmutex.h>
+#include <qobject.h>
+
+// Settings used while processing, copied because Settings belongs to the GUI thread.
+struct JenkinsParseSettings
+{
+	JenkinsParseSettings();
+	explicit JenkinsParseSettings(const class Settings& settings);
+
+	ProjectFilter projectFilter;
+	bool showDisabledProjects;
+	std::vector<QString> ignoreUserList;
+};
+
+// Project of a server listing that passed the filters.
+struct JenkinsListedProject
+{
+	ProjectInformation info;
+	bool hasBuildInformation; // Otherwise only the state of the job is known.
+	qint32 lastBuildNumber;
+};
+
+struct JenkinsListing
+{
+	QString server;
+	bool succeeded;
+	std::vector<QString> allProjects;
+	std::vector<JenkinsListedProject> projects;
+};
+
+struct JenkinsProjectResult
+{
+	quint64 retrievalId;
+	ProjectInformation info;
+};
+
+// Turns Jenkins replies into project information on a thread of its own, so large servers don't stall
+// the interface. Processing is requested from the GUI thread with QMetaObject::invokeMethod.
+class JenkinsParseWorker : public QObject
+{
+	Q_OBJECT
+
+public:
+	JenkinsParseWorker(QThread& workerThread);
+
+	// Safe to call from the GUI thread.
+	void prepareListingRequest(QNetworkRequest& request);
+	void prepareBuildRequest(QNetworkRequest& request);
+
+	// Only to be called on the worker thread.
+	void setParseSettings(const JenkinsParseSettings& settings);
+	void parseListingData(const QString& server, const QByteArray& data, bool isFirst);
+	void processListing(const QString& server, const JenkinsReply& reply);
+	void processProject(quint64 retrievalId, ProjectInformation info, const JenkinsReply& lastBuildReply,
+		const JenkinsReply& lastSuccessfulBuildReply);
+	void removeServer(const QString& server);
+
+Q_SIGNALS:
+	void listingProcessed(const JenkinsListing& listing);
+	void projectProcessed(const JenkinsProjectResult& result);
+
+private:
+	const JenkinsBuildInformation* findBuild(const JenkinsReply& reply, JenkinsBuildInformation& parsedBuild);
+	void pruneBuildCache(const QUrl& serverURL, const std::vector<JenkinsJobInformation>& jobs);
+	static bool isOnServer(const QUrl& url, const QUrl& serverURL);
+	static JenkinsBuildInformation parseBuild(const class QJsonObject& object);
+	void applyLastBuild(const JenkinsBuildInformation& build, ProjectInformation& info) const;
+	void applyLastSuccessfulBuild(const JenkinsBuildInformation& build, ProjectInformation& info) const;
+
+	JenkinsParseSettings settings;
+	QHash<QString, JenkinsJobListParser> listingParsers;
+
+	// Also used by the GUI thread to make requests conditional.
+	QMutex cacheMutex;
+	JenkinsResponseCache<std::vector<JenkinsJobInformation> > jobListCache;
+	JenkinsResponseCache<JenkinsBuildInformation> buildCache;
+};
+
+Q_DECLARE_METATYPE(JenkinsListing);
+Q_DECLARE_METATYPE(JenkinsProjectResult);
@@ -0,0 +1,165 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JenkinsRequestScheduler.h"
+
+#include <qnetworkaccessmanager.h>
+#include <qnetworkreply.h>
+#include <qtimer.h>
+
+#include <memory>
+
+// The total is derived from the limit per server, so the configured limit always applies to a few servers
+// at once. With the default of 4 requests per server this allows 16 requests in total.
+constexpr qint32 MAXIMUM_BUSY_HOSTS = 4;
+constexpr qint32 REQUEST_TIMEOUT_MS = 30000;
+constexpr qint32 MAXIMUM_RETRIES = 3;
+constexpr qint32 RETRY_DELAY_MS = 1000; // Doubled for every retry of the same request.
+
+JenkinsRequestScheduler::JenkinsRequestScheduler(QObject* parent) :
+	QObject(parent),
+	networkAccessManager(new QNetworkAccessManager(this)),
+	maximumRequestsPerHost(4),
+	activeRequests(0)
+{
+}
+
+void JenkinsRequestScheduler::setMaximumRequestsPerHost(qint32 maximumRequests)
+{
+	maximumRequestsPerHost = maximumRequests > 0 ? maximumRequests : 1;
+	processQueues();
+}
+
+void JenkinsRequestScheduler::get(const QNetworkRequest& request, EJenkinsRequestPriority priority, const Callback& callback,
+	const DataCallback& dataCallback)
+{
+	enqueue({ request, priority, callback, dataCallback, 0 });
+}
+
+void JenkinsRequestScheduler::enqueue(const PendingRequest& pendingRequest)
+{
+	Host& host = hosts[pendingRequest.request.url().host()];
+	host.queues[static_cast<size_t>(pendingRequest.priority)].emplace_back(pendingRequest);
+
+	processQueues();
+}
+
+void JenkinsRequestScheduler::processQueues()
+{
+	for (size_t priority = 0; priority < static_cast<size_t>(EJenkinsRequestPriority::Count); ++priority)
+	{
+		for (QHash<QString, Host>::iterator host = hosts.begin(); host != hosts.end(); ++host)
+		{
+			std::deque<PendingRequest>& queue = host->queues[priority];
+			while (!queue.empty() && host->activeRequests < maximumRequestsPerHost)
+			{
+				if (activeRequests >= maximumRequestsPerHost * MAXIMUM_BUSY_HOSTS)
+				{
+					return;
+				}
+
+				const PendingRequest pendingRequest = queue.front();
+				queue.pop_front();
+				++host->activeRequests;
+				++activeRequests;
+				start(host.key(), pendingRequest);
+			}
+		}
+	}
+}
+
+void JenkinsRequestScheduler::start(const QString& hostName, const PendingRequest& pendingRequest)
+{
+	QNetworkReply* reply = networkAccessManager->get(pendingRequest.request);
+
+	// Aborting results in an OperationCanceledError, which is retried.
+	QTimer* timeout = new QTimer(reply);
+	timeout->setSingleShot(true);
+	connect(timeout, &QTimer::timeout, reply, &QNetworkReply::abort);
+	timeout->start(REQUEST_TIMEOUT_MS);
+
+	if (pendingRequest.dataCallback)
+	{
+		// Shared by both connections, the last data may still be unread when the reply finishes.
+		std::shared_ptr<bool> isFirst = std::make_shared<bool>(true);
+		connect(reply, &QNetworkReply::readyRead, this, [pendingRequest, reply, isFirst]()
+		{
+			readData(pendingRequest, reply, *isFirst);
+		});
+		connect(reply, &QNetworkReply::finished, this, [this, hostName, pendingRequest, reply, isFirst]()
+		{
+			readData(pendingRequest, reply, *isFirst);
+			onFinished(hostName, pendingRequest, reply);
+		});
+	}
+	else
+	{
+		connect(reply, &QNetworkReply::finished, this, [this, hostName, pendingRequest, reply]()
+		{
+			onFinished(hostName, pendingRequest, reply);
+		});
+	}
+}
+
+void JenkinsRequestScheduler::onFinished(const QString& hostName, const PendingRequest& pendingRequest, QNetworkReply* reply)
+{
+	reply->deleteLater();
+
+	Host& host = hosts[hostName];
+	--host.activeRequests;
+	--activeRequests;
+
+	if (shouldRetry(reply) && pendingRequest.attempt < MAXIMUM_RETRIES)
+	{
+		PendingRequest retry = pendingRequest;
+		++retry.attempt;
+		QTimer::singleShot(RETRY_DELAY_MS << pendingRequest.attempt, this, [this, retry]() { enqueue(retry); });
+	}
+	else
+	{
+		pendingRequest.callback(reply);
+	}
+
+	processQueues();
+}
+
+void JenkinsRequestScheduler::readData(const PendingRequest& pendingRequest, QNetworkReply* reply, bool& isFirst)
+{
+	if (reply->bytesAvailable() > 0)
+	{
+		pendingRequest.dataCallback(reply->readAll(), isFirst);
+		isFirst = false;
+	}
+}
+
+bool JenkinsRequestScheduler::shouldRetry(const QNetworkReply* reply)
+{
+	switch (reply->error())
+	{
+	case QNetworkReply::OperationCanceledError:
+	case QNetworkReply::TimeoutError:
+	case QNetworkReply::RemoteHostClosedError:
+	case QNetworkReply::TemporaryNetworkFailureError:
+	case QNetworkReply::NetworkSessionFailedError:
+	case QNetworkReply::ServiceUnavailableError:
+	case QNetworkReply::UnknownServerError:
+		return true;
+
+	default:
+		return false;
+	}
+}
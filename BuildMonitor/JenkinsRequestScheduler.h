@@ -0,0 +1,91 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <qhash.h>
+#include <qnetworkrequest.h>
+#include <qobject.h>
+
+#include <deque>
+#include <functional>
+
+// Ordered from most to least important.
+enum class EJenkinsRequestPriority
+{
+	ServerListing,
+	ActiveProject, // Building or failed projects.
+	IdleProject,
+	Count
+};
+
+// Sends requests to Jenkins with a bounded number of requests in flight per server and in total, the total
+// being a multiple of the limit per server. Requests are started in order of priority, timed out requests
+// and transient errors are retried with a backoff.
+class JenkinsRequestScheduler : public QObject
+{
+	Q_OBJECT
+
+public:
+	// The reply is deleted after the callback returns.
+	typedef std::function<void(class QNetworkReply* reply)> Callback;
+
+	// Receives the body while it arrives, ahead of the callback. Data of a failed attempt is to be discarded
+	// once the retry passes its first data with isFirst set.
+	typedef std::function<void(const QByteArray& data, bool isFirst)> DataCallback;
+
+	JenkinsRequestScheduler(QObject* parent);
+
+	void setMaximumRequestsPerHost(qint32 maximumRequests);
+
+	void get(const QNetworkRequest& request, EJenkinsRequestPriority priority, const Callback& callback,
+		const DataCallback& dataCallback = DataCallback());
+
+private:
+	struct PendingRequest
+	{
+		QNetworkRequest request;
+		EJenkinsRequestPriority priority;
+		Callback callback;
+		DataCallback dataCallback;
+		qint32 attempt;
+	};
+
+	struct Host
+	{
+		Host() :
+			activeRequests(0)
+		{
+		}
+
+		std::deque<PendingRequest> queues[static_cast<size_t>(EJenkinsRequestPriority::Count)];
+		qint32 activeRequests;
+	};
+
+	void enqueue(const PendingRequest& pendingRequest);
+	void processQueues();
+	void start(const QString& hostName, const PendingRequest& pendingRequest);
+	void onFinished(const QString& hostName, const PendingRequest& pendingRequest, class QNetworkReply* reply);
+
+	static void readData(const PendingRequest& pendingRequest, class QNetworkReply* reply, bool& isFirst);
+	static bool shouldRetry(const class QNetworkReply* reply);
+
+	class QNetworkAccessManager* networkAccessManager;
+	QHash<QString, Host> hosts;
+	qint32 maximumRequestsPerHost;
+	qint32 activeRequests;
+};
@@ -0,0 +1,122 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <qhash.h>
+#include <qnetworkreply.h>
+#include <qnetworkrequest.h>
+#include <qurl.h>
+
+// What is needed of a finished reply, copied so it can be used on any thread.
+struct JenkinsReply
+{
+	JenkinsReply() :
+		succeeded(false),
+		isNotModified(false)
+	{
+	}
+
+	explicit JenkinsReply(QNetworkReply* reply) :
+		url(reply->request().url()),
+		succeeded(reply->error() == QNetworkReply::NoError),
+		isNotModified(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304),
+		eTag(reply->rawHeader("ETag")),
+		lastModified(reply->rawHeader("Last-Modified")),
+		body(reply->readAll())
+	{
+	}
+
+	QUrl url;
+	bool succeeded;
+	bool isNotModified;
+	QByteArray eTag;
+	QByteArray lastModified;
+	QByteArray body;
+};
+
+// Remembers the validators Jenkins sent along with a response together with what was parsed from it, so the
+// request can be made conditional and an unchanged resource doesn't have to be transferred or parsed again.
+template<typename T>
+class JenkinsResponseCache
+{
+public:
+	void prepareRequest(QNetworkRequest& request) const
+	{
+		const typename QHash<QUrl, Entry>::const_iterator entry = entries.constFind(request.url());
+		if (entry != entries.constEnd())
+		{
+			if (!entry->eTag.isEmpty())
+			{
+				request.setRawHeader("If-None-Match", entry->eTag);
+			}
+			if (!entry->lastModified.isEmpty())
+			{
+				request.setRawHeader("If-Modified-Since", entry->lastModified);
+			}
+		}
+	}
+
+	// Returns what was stored for the request of a reply that reported the resource as unchanged.
+	const T* find(const JenkinsReply& reply) const
+	{
+		const typename QHash<QUrl, Entry>::const_iterator entry = entries.constFind(reply.url);
+		return entry != entries.constEnd() ? &entry->value : nullptr;
+	}
+
+	void store(const JenkinsReply& reply, const T& value)
+	{
+		if (reply.eTag.isEmpty() && reply.lastModified.isEmpty())
+		{
+			entries.remove(reply.url); // Nothing to validate against, keeping the value would only cost memory.
+			return;
+		}
+
+		Entry& entry = entries[reply.url];
+		entry.eTag = reply.eTag;
+		entry.lastModified = reply.lastModified;
+		entry.value = value;
+	}
+
+	// Removes the entries of which the predicate accepts the URL.
+	template<typename Predicate>
+	void removeIf(const Predicate& predicate)
+	{
+		typename QHash<QUrl, Entry>::iterator entry = entries.begin();
+		while (entry != entries.end())
+		{
+			if (predicate(entry.key()))
+			{
+				entry = entries.erase(entry);
+			}
+			else
+			{
+				++entry;
+			}
+		}
+	}
+
+private:
+	struct Entry
+	{
+		QByteArray eTag;
+		QByteArray lastModified;
+		T value;
+	};
+
+	QHash<QUrl, Entry> entries;
+};
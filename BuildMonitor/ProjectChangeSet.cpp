@@ -0,0 +1,102 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProjectChangeSet.h"
+
+#include <qhash.h>
+
+ProjectChangeSet::ProjectChangeSet(const ProjectSnapshot& last, const ProjectSnapshot& current)
+{
+	QHash<quint64, size_t> lastIndices;
+	lastIndices.reserve(static_cast<int>(last.size()));
+	for (size_t index = 0; index < last.size(); ++index)
+	{
+		lastIndices.insert(last[index].getKey(), index);
+	}
+
+	std::vector<bool> isMatched(last.size(), false);
+	for (size_t index = 0; index < current.size(); ++index)
+	{
+		const QHash<quint64, size_t>::const_iterator lastIndex = lastIndices.constFind(current[index].getKey());
+		if (lastIndex == lastIndices.constEnd())
+		{
+			changes.push_back({ EProjectChange::Added, index });
+			continue;
+		}
+
+		isMatched[lastIndex.value()] = true;
+		compare(last[lastIndex.value()], current[index], index);
+	}
+
+	for (size_t index = 0; index < last.size(); ++index)
+	{
+		if (!isMatched[index])
+		{
+			changes.push_back({ EProjectChange::Removed, index });
+		}
+	}
+}
+
+const std::vector<ProjectChange>& ProjectChangeSet::getChanges() const
+{
+	return changes;
+}
+
+bool ProjectChangeSet::isEmpty() const
+{
+	return changes.empty();
+}
+
+bool ProjectChangeSet::affectsStatus() const
+{
+	return std::find_if(changes.begin(), changes.end(),
+		[](const ProjectChange& change) { return change.type != EProjectChange::Updated; }) != changes.end();
+}
+
+void ProjectChangeSet::compare(const ProjectInformation& last, const ProjectInformation& current, size_t index)
+{
+	if (projectStatus_isFailure(current.status) && last.status == EProjectStatus::Succeeded)
+	{
+		changes.push_back({ EProjectChange::Broke, index });
+	}
+	else if (current.status == EProjectStatus::Succeeded && projectStatus_isFailure(last.status))
+	{
+		changes.push_back({ EProjectChange::Fixed, index });
+	}
+	else if (current.status != last.status)
+	{
+		changes.push_back({ EProjectChange::StatusChanged, index });
+	}
+
+	if (current.isBuilding != last.isBuilding)
+	{
+		changes.push_back({ current.isBuilding ? EProjectChange::StartedBuilding : EProjectChange::FinishedBuilding, index });
+	}
+
+	if (current.buildNumber != last.buildNumber ||
+		current.estimatedRemainingTime != last.estimatedRemainingTime ||
+		current.inProgressFor != last.inProgressFor ||
+		current.lastBuildDuration != last.lastBuildDuration ||
+		current.lastSuccessfulBuildTime != last.lastSuccessfulBuildTime ||
+		current.buildStartTime != last.buildStartTime ||
+		current.estimatedDuration != last.estimatedDuration ||
+		current.projectPath != last.projectPath ||
+		current.initiatedBy != last.initiatedBy)
+	{
+		changes.push_back({ EProjectChange::Updated, index });
+	}
+}
@@ -0,0 +1,59 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "ProjectSnapshot.h"
+
+#include <vector>
+
+enum class EProjectChange
+{
+	Added,
+	Removed,
+	Broke, // Went from succeeded to a failure.
+	Fixed, // Went from a failure to succeeded.
+	StatusChanged, // Any other change of status.
+	StartedBuilding,
+	FinishedBuilding,
+	Updated // Changes to anything else that is shown.
+};
+
+struct ProjectChange
+{
+	EProjectChange type;
+	size_t index; // Into the current snapshot, or into the last one for removed projects.
+};
+
+// Differences between two snapshots, found in a single pass by matching projects on their server and name. A project
+// can have multiple changes, for example when it finished building and broke.
+class ProjectChangeSet
+{
+public:
+	ProjectChangeSet(const ProjectSnapshot& last, const ProjectSnapshot& current);
+
+	const std::vector<ProjectChange>& getChanges() const;
+	bool isEmpty() const;
+
+	// Whether the combined status of all projects may have changed.
+	bool affectsStatus() const;
+
+private:
+	void compare(const ProjectInformation& last, const ProjectInformation& current, size_t index);
+
+	std::vector<ProjectChange> changes;
+};
@@ -0,0 +1,65 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProjectFilter.h"
+#include "Settings.h"
+
+// Matches the whole name, like QRegExp::exactMatch did.
+static QRegularExpression createExactExpression(const QString& pattern)
+{
+	return QRegularExpression("\\A(?:" + pattern + ")\\z", QRegularExpression::OptimizeOnFirstUsageOption);
+}
+
+ProjectFilter::ProjectFilter() :
+	useRegEx(false)
+{
+}
+
+ProjectFilter::ProjectFilter(const Settings& settings) :
+	useRegEx(settings.useRegExProjectFilter),
+	includeRegEx(createExactExpression(settings.projectIncludeRegEx.pattern())),
+	excludeRegEx(createExactExpression(settings.projectExcludeRegEx.pattern()))
+{
+	enabledProjects.reserve(static_cast<int>(settings.enabledProjectList.size()));
+	for (const QString& project : settings.enabledProjectList)
+	{
+		enabledProjects.insert(project);
+	}
+}
+
+bool ProjectFilter::isShown(const QString& projectName) const
+{
+	const QHash<QString, bool>::const_iterator decision = decisions.constFind(projectName);
+	if (decision != decisions.constEnd())
+	{
+		return decision.value();
+	}
+
+	const bool isProjectShown = evaluate(projectName);
+	decisions.insert(projectName, isProjectShown);
+	return isProjectShown;
+}
+
+bool ProjectFilter::evaluate(const QString& projectName) const
+{
+	if (useRegEx)
+	{
+		return includeRegEx.match(projectName).hasMatch() && !excludeRegEx.match(projectName).hasMatch();
+	}
+
+	return enabledProjects.contains(projectName);
+}
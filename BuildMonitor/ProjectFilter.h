@@ -0,0 +1,44 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <qhash.h>
+#include <qregularexpression.h>
+#include <qset.h>
+#include <qstring.h>
+
+// Decides which projects are shown, built once whenever the settings change. Decisions are remembered per
+// project name, so refreshes after the first one only cost a hash lookup per project.
+class ProjectFilter
+{
+public:
+	ProjectFilter();
+	explicit ProjectFilter(const class Settings& settings);
+
+	bool isShown(const QString& projectName) const;
+
+private:
+	bool evaluate(const QString& projectName) const;
+
+	bool useRegEx;
+	QSet<QString> enabledProjects;
+	QRegularExpression includeRegEx;
+	QRegularExpression excludeRegEx;
+
+	mutable QHash<QString, bool> decisions;
+};
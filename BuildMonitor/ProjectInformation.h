@@ -18,35 +18,65 @@
 #pragma once
 
 #include "ProjectStatus.h"
+#include "StringTable.h"
 
-#include <qstring.h>
 #include <qurl.h>
+#include <qvarlengtharray.h>
 
-#include <vector>
-
+// Kept small since it is copied for every project on every refresh, names are ids into the StringTable.
 class ProjectInformation
 {
 public:
 	ProjectInformation() :
-		status(EProjectStatus::Unknown),
-		isBuilding(false),
-		buildNumber(0),
 		estimatedRemainingTime(0),
 		inProgressFor(0),
 		lastBuildDuration(0),
-		lastSuccessfulBuildTime(-1)
+		lastSuccessfulBuildTime(-1),
+		buildStartTime(0),
+		estimatedDuration(0),
+		projectName(0),
+		server(0),
+		projectPath(0),
+		buildNumber(0),
+		status(EProjectStatus::Unknown),
+		isBuilding(false)
 	{
 	}
 
-	QString projectName;
-	QUrl projectUrl;
-	EProjectStatus status;
-	bool isBuilding;
-	qint32 buildNumber;
+	const QString& getProjectName() const
+	{
+		return StringTable::get(projectName);
+	}
+
+	// Identifies the project across servers, which can have jobs of the same name.
+	quint64 getKey() const
+	{
+		return makeKey(server, projectName);
+	}
+
+	static quint64 makeKey(StringId server, StringId projectName)
+	{
+		return (static_cast<quint64>(server) << 32) | projectName;
+	}
+
+	QUrl getProjectUrl() const
+	{
+		QUrl projectUrl(StringTable::get(server));
+		projectUrl.setPath(StringTable::get(projectPath));
+		return projectUrl;
+	}
+
 	qint64 estimatedRemainingTime;
 	qint64 inProgressFor;
 	qint64 lastBuildDuration;
 	qint64 lastSuccessfulBuildTime;
-	QString volunteer;
-	std::vector<QString> initiatedBy;
+	qint64 buildStartTime; // Of the last build, keeps the progress of builds up to date between refreshes.
+	qint64 estimatedDuration; // Of the build in progress.
+	StringId projectName;
+	StringId server; // The server URL as configured.
+	StringId projectPath; // Path of the project page on the server.
+	qint32 buildNumber;
+	EProjectStatus status;
+	bool isBuilding;
+	QVarLengthArray<StringId, 2> initiatedBy; // Sorted by name.
 };
@@ -0,0 +1,149 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ProjectInformationCache.h"
+
+#include <qdatastream.h>
+#include <qfile.h>
+#include <qsavefile.h>
+
+// Files of other versions are ignored, the cache is rebuilt by the next refresh.
+constexpr quint32 CACHE_MAGIC = 0x424D5043; // "BMPC"
+constexpr quint32 CACHE_VERSION = 1;
+
+static void writeString(QDataStream& stream, StringId id)
+{
+	stream << StringTable::get(id);
+}
+
+static StringId readString(QDataStream& stream)
+{
+	QString string;
+	stream >> string;
+	return StringTable::intern(string);
+}
+
+bool ProjectInformationCache::load(const QString& fileName, std::vector<ProjectInformation>& projects, std::vector<QString>& allAvailableProjects)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+	{
+		return false;
+	}
+
+	// Mapped instead of read, the data is only looked at once. It is unmapped when the file closes.
+	const uchar* mappedData = file.map(0, file.size());
+	if (mappedData == nullptr)
+	{
+		return false;
+	}
+	const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char*>(mappedData), static_cast<int>(file.size()));
+	QDataStream stream(data);
+	stream.setVersion(QDataStream::Qt_5_10);
+
+	quint32 magic = 0;
+	quint32 version = 0;
+	stream >> magic >> version;
+	if (magic != CACHE_MAGIC || version != CACHE_VERSION)
+	{
+		return false;
+	}
+
+	quint32 projectCount = 0;
+	stream >> projectCount;
+	std::vector<ProjectInformation> loadedProjects;
+	for (quint32 i = 0; i < projectCount && stream.status() == QDataStream::Ok; ++i)
+	{
+		ProjectInformation info;
+		info.projectName = readString(stream);
+		info.server = readString(stream);
+		info.projectPath = readString(stream);
+		stream >> info.estimatedRemainingTime >> info.inProgressFor >> info.lastBuildDuration >> info.lastSuccessfulBuildTime
+			>> info.buildStartTime >> info.estimatedDuration >> info.buildNumber;
+
+		qint8 status = 0;
+		stream >> status >> info.isBuilding;
+		info.status = status >= 0 && status <= static_cast<qint8>(EProjectStatus::Unknown) ?
+			static_cast<EProjectStatus>(status) : EProjectStatus::Unknown;
+
+		quint32 initiatedByCount = 0;
+		stream >> initiatedByCount;
+		for (quint32 j = 0; j < initiatedByCount && stream.status() == QDataStream::Ok; ++j)
+		{
+			info.initiatedBy.append(readString(stream));
+		}
+
+		loadedProjects.emplace_back(info);
+	}
+
+	quint32 availableProjectCount = 0;
+	stream >> availableProjectCount;
+	std::vector<QString> loadedAvailableProjects;
+	for (quint32 i = 0; i < availableProjectCount && stream.status() == QDataStream::Ok; ++i)
+	{
+		QString project;
+		stream >> project;
+		loadedAvailableProjects.emplace_back(project);
+	}
+
+	if (stream.status() != QDataStream::Ok)
+	{
+		return false;
+	}
+
+	projects = std::move(loadedProjects);
+	allAvailableProjects = std::move(loadedAvailableProjects);
+	return true;
+}
+
+void ProjectInformationCache::save(const QString& fileName, const std::vector<ProjectInformation>& projects, const std::vector<QString>& allAvailableProjects)
+{
+	// Written to a temporary file first, so an interrupted save doesn't leave a broken cache behind.
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		return;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_10);
+	stream << CACHE_MAGIC << CACHE_VERSION;
+
+	stream << static_cast<quint32>(projects.size());
+	for (const ProjectInformation& info : projects)
+	{
+		writeString(stream, info.projectName);
+		writeString(stream, info.server);
+		writeString(stream, info.projectPath);
+		stream << info.estimatedRemainingTime << info.inProgressFor << info.lastBuildDuration << info.lastSuccessfulBuildTime
+			<< info.buildStartTime << info.estimatedDuration << info.buildNumber;
+		stream << static_cast<qint8>(info.status) << info.isBuilding;
+
+		stream << static_cast<quint32>(info.initiatedBy.size());
+		for (StringId user : info.initiatedBy)
+		{
+			writeString(stream, user);
+		}
+	}
+
+	stream << static_cast<quint32>(allAvailableProjects.size());
+	for (const QString& project : allAvailableProjects)
+	{
+		stream << project;
+	}
+
+	file.commit();
+}
@@ -14,29 +14,19 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-
 #pragma once
 
-#include "FixInfo.h"
+#include "ProjectInformation.h"
 
-#include <qtcpsocket.h>
-#include <qthread.h>
+#include <qstring.h>
 
-class AcceptThread : public QThread
-{
-	Q_OBJECT
+#include <vector>
 
+// Keeps the projects of the last session on disk, so they can be shown at startup until the first refresh
+// finishes. Names are stored as strings, string ids are only valid within a session.
+class ProjectInformationCache
+{
 public:
-	AcceptThread(qintptr socketDescriptor, class Server& inServer, QObject* parent);
-
-	void run();
-
-signals:
-	void fixStarted(const FixInfo& fixInfo);
-	void markFixed(const QString& projectName, const qint32 buildNumber);
-	void error(QTcpSocket::SocketError socketError);
-
-private:
-	class Server& server;
-	qintptr socketDescriptor;
+	static bool load(const QString& fileName, std::vector<ProjectInformation>& projects, std::vector<QString>& allAvailableProjects);
+	static void save(const QString& fileName, const std::vector<ProjectInformation>& projects, const std::vector<QString>& allAvailableProjects);
 };
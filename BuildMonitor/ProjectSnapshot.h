@@ -0,0 +1,129 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "ProjectInformation.h"
+
+#include <qmetatype.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Immutable list of projects as published by a single refresh. Copies share the same list, so it can be held
+// by any number of consumers and threads without copying the projects. Newer publications have a higher generation.
+// Projects of cached servers are the information of an earlier session, shown until their server answers. Projects
+// of stale servers are the last known information of a server that couldn't be reached.
+class ProjectSnapshot
+{
+public:
+	typedef std::vector<ProjectInformation>::const_iterator const_iterator;
+
+	ProjectSnapshot() :
+		projects(std::make_shared<const std::vector<ProjectInformation> >()),
+		staleServers(std::make_shared<const std::vector<StringId> >()),
+		cachedServers(std::make_shared<const std::vector<StringId> >()),
+		generation(0)
+	{
+	}
+
+	ProjectSnapshot(std::vector<ProjectInformation>&& inProjects, quint64 inGeneration,
+		std::vector<StringId>&& inStaleServers = std::vector<StringId>(),
+		std::vector<StringId>&& inCachedServers = std::vector<StringId>()) :
+		projects(std::make_shared<const std::vector<ProjectInformation> >(std::move(inProjects))),
+		staleServers(std::make_shared<const std::vector<StringId> >(std::move(inStaleServers))),
+		cachedServers(std::make_shared<const std::vector<StringId> >(std::move(inCachedServers))),
+		generation(inGeneration)
+	{
+	}
+
+	const std::vector<ProjectInformation>& getProjects() const
+	{
+		return *projects;
+	}
+
+	const std::vector<StringId>& getStaleServers() const
+	{
+		return *staleServers;
+	}
+
+	const std::vector<StringId>& getCachedServers() const
+	{
+		return *cachedServers;
+	}
+
+	quint64 getGeneration() const
+	{
+		return generation;
+	}
+
+	// Whether any server still shows the information of an earlier session.
+	bool isStale() const
+	{
+		return !cachedServers->empty();
+	}
+
+	bool isServerStale(StringId server) const
+	{
+		return std::find(staleServers->begin(), staleServers->end(), server) != staleServers->end();
+	}
+
+	bool isServerCached(StringId server) const
+	{
+		return std::find(cachedServers->begin(), cachedServers->end(), server) != cachedServers->end();
+	}
+
+	// Stale and cached projects are shown as unconfirmed.
+	bool isProjectStale(const ProjectInformation& info) const
+	{
+		return isServerStale(info.server) || isServerCached(info.server);
+	}
+
+	size_t size() const
+	{
+		return projects->size();
+	}
+
+	bool empty() const
+	{
+		return projects->empty();
+	}
+
+	const ProjectInformation& operator[](size_t index) const
+	{
+		return (*projects)[index];
+	}
+
+	const_iterator begin() const
+	{
+		return projects->begin();
+	}
+
+	const_iterator end() const
+	{
+		return projects->end();
+	}
+
+private:
+	std::shared_ptr<const std::vector<ProjectInformation> > projects;
+	std::shared_ptr<const std::vector<StringId> > staleServers;
+	std::shared_ptr<const std::vector<StringId> > cachedServers;
+	quint64 generation;
+};
+
+Q_DECLARE_METATYPE(ProjectSnapshot);
@@ -0,0 +1,486 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProjectTableModel.h"
+#include "BuildHistory.h"
+#include "ProjectChangeSet.h"
+
+#include <qcolor.h>
+#include <qdatetime.h>
+#include <qicon.h>
+#include <qtextstream.h>
+#include <qtimer.h>
+
+#include <algorithm>
+
+// Builds in progress have their elapsed and remaining time extrapolated from their start, so progress is
+// shown without refreshing more often.
+constexpr int PROGRESS_UPDATE_INTERVAL_MS = 1000;
+
+constexpr qint64 HISTORY_SUMMARY_PERIOD_S = 7 * 24 * 60 * 60;
+
+static quint32 getColumnBit(EProjectTableColumn column)
+{
+	return 1u << static_cast<quint32>(column);
+}
+
+// Columns of which the text or icon differs between two versions of a project.
+static quint32 getChangedColumns(const ProjectInformation& last, const ProjectInformation& current)
+{
+	quint32 columns = 0;
+	if (current.status != last.status || current.isBuilding != last.isBuilding)
+	{
+		columns |= getColumnBit(EProjectTableColumn::Status);
+	}
+	if (current.isBuilding != last.isBuilding ||
+		current.estimatedRemainingTime != last.estimatedRemainingTime ||
+		current.buildStartTime != last.buildStartTime ||
+		current.estimatedDuration != last.estimatedDuration)
+	{
+		columns |= getColumnBit(EProjectTableColumn::RemainingTime);
+	}
+	if (current.isBuilding != last.isBuilding ||
+		current.inProgressFor != last.inProgressFor ||
+		current.buildStartTime != last.buildStartTime)
+	{
+		columns |= getColumnBit(EProjectTableColumn::Duration);
+	}
+	if (current.lastSuccessfulBuildTime != last.lastSuccessfulBuildTime)
+	{
+		columns |= getColumnBit(EProjectTableColumn::LastSuccessfulBuild);
+	}
+	if (current.buildNumber != last.buildNumber || current.status != last.status || current.isBuilding != last.isBuilding)
+	{
+		columns |= getColumnBit(EProjectTableColumn::History); // Finished builds are recorded before they are published.
+	}
+	if (current.initiatedBy != last.initiatedBy)
+	{
+		columns |= getColumnBit(EProjectTableColumn::InitiatedBy);
+	}
+	return columns;
+}
+
+ProjectTableModel::ProjectTableModel(QObject* parent) :
+	QAbstractTableModel(parent),
+	succeeded(nullptr),
+	succeededBuilding(nullptr),
+	failed(nullptr),
+	failedBuilding(nullptr),
+	progressTimer(new QTimer(this)),
+	buildHistory(nullptr)
+{
+	progressTimer->setInterval(PROGRESS_UPDATE_INTERVAL_MS);
+	connect(progressTimer, &QTimer::timeout, this, &ProjectTableModel::updateProgress);
+}
+
+void ProjectTableModel::setIcons(const QIcon* inSucceeded, const QIcon* inSucceededBuilding,
+	const QIcon* inFailed, const QIcon* inFailedBuilding)
+{
+	succeeded = inSucceeded;
+	succeededBuilding = inSucceededBuilding;
+	failed = inFailed;
+	failedBuilding = inFailedBuilding;
+}
+
+void ProjectTableModel::setBuildHistory(const BuildHistory* inBuildHistory)
+{
+	buildHistory = inBuildHistory;
+	for (FormattedRow& formattedRow : formattedRows)
+	{
+		formattedRow.formattedColumns &= ~(1u << static_cast<quint32>(EProjectTableColumn::History));
+	}
+
+	if (!rows.empty())
+	{
+		const int historyColumn = static_cast<int>(EProjectTableColumn::History);
+		dataChanged(index(0, historyColumn), index(static_cast<int>(rows.size()) - 1, historyColumn));
+	}
+}
+
+void ProjectTableModel::setProjectInformation(const ProjectSnapshot& inProjectInformation, const QHash<StringId, StringId>& inVolunteers)
+{
+	const ProjectSnapshot lastProjectInformation = projectInformation;
+	const ProjectChangeSet changeSet(lastProjectInformation, inProjectInformation);
+	projectInformation = inProjectInformation;
+
+	// Both snapshots are sorted by name and server, and rows are matched on both. Once the removed rows are gone
+	// the remaining ones are in the same order in both, so the added rows can be inserted at their final position
+	// from top to bottom.
+	std::vector<size_t> removedRows;
+	std::vector<size_t> addedRows;
+	for (const ProjectChange& change : changeSet.getChanges())
+	{
+		if (change.type == EProjectChange::Removed)
+		{
+			removedRows.push_back(change.index);
+		}
+		else if (change.type == EProjectChange::Added)
+		{
+			addedRows.push_back(change.index);
+		}
+	}
+	std::sort(removedRows.begin(), removedRows.end());
+	std::sort(addedRows.begin(), addedRows.end());
+
+	// Consecutive rows are removed and inserted at once.
+	for (size_t end = removedRows.size(); end != 0;)
+	{
+		size_t begin = end - 1;
+		while (begin != 0 && removedRows[begin - 1] + 1 == removedRows[begin])
+		{
+			--begin;
+		}
+
+		beginRemoveRows(QModelIndex(), static_cast<int>(removedRows[begin]), static_cast<int>(removedRows[end - 1]));
+		rows.erase(rows.begin() + removedRows[begin], rows.begin() + removedRows[end - 1] + 1);
+		formattedRows.erase(formattedRows.begin() + removedRows[begin], formattedRows.begin() + removedRows[end - 1] + 1);
+		endRemoveRows();
+		end = begin;
+	}
+
+	for (size_t begin = 0; begin != addedRows.size();)
+	{
+		size_t end = begin + 1;
+		while (end != addedRows.size() && addedRows[end - 1] + 1 == addedRows[end])
+		{
+			++end;
+		}
+
+		beginInsertRows(QModelIndex(), static_cast<int>(addedRows[begin]), static_cast<int>(addedRows[end - 1]));
+		rows.insert(rows.begin() + addedRows[begin], end - begin, nullptr);
+		formattedRows.insert(formattedRows.begin() + addedRows[begin], end - begin, FormattedRow());
+		for (size_t row = addedRows[begin]; row <= addedRows[end - 1]; ++row)
+		{
+			rows[row] = &projectInformation[row];
+		}
+		endInsertRows();
+		begin = end;
+	}
+
+	// The rows that were kept still point into the last snapshot. Only the cells that differ are changed, so the
+	// view doesn't measure the other columns again.
+	std::vector<std::pair<size_t, quint32> > changedRows;
+	for (const ProjectChange& change : changeSet.getChanges())
+	{
+		if (change.type != EProjectChange::Added && change.type != EProjectChange::Removed &&
+			(changedRows.empty() || changedRows.back().first != change.index))
+		{
+			changedRows.emplace_back(change.index, getChangedColumns(*rows[change.index], projectInformation[change.index]));
+		}
+	}
+
+	for (size_t row = 0; row < rows.size(); ++row)
+	{
+		rows[row] = &projectInformation[row];
+	}
+
+	// Rows of servers that became stale or reachable again change their appearance only.
+	if (lastProjectInformation.getStaleServers() != projectInformation.getStaleServers() ||
+		lastProjectInformation.getCachedServers() != projectInformation.getCachedServers())
+	{
+		const quint32 allColumns = getColumnBit(EProjectTableColumn::Count) - 1;
+		for (size_t row = 0; row < rows.size(); ++row)
+		{
+			if (lastProjectInformation.isProjectStale(*rows[row]) != projectInformation.isProjectStale(*rows[row]))
+			{
+				emitCellsChanged(static_cast<qint32>(row), allColumns);
+			}
+		}
+	}
+
+	for (const std::pair<size_t, quint32>& changedRow : changedRows)
+	{
+		formattedRows[changedRow.first].formattedColumns &= ~changedRow.second;
+		emitCellsChanged(static_cast<qint32>(changedRow.first), changedRow.second);
+	}
+
+	const bool isBuilding = std::find_if(projectInformation.begin(), projectInformation.end(),
+		[](const ProjectInformation& info) { return info.isBuilding && info.buildStartTime != 0; }) != projectInformation.end();
+	if (isBuilding && !progressTimer->isActive())
+	{
+		progressTimer->start();
+	}
+	else if (!isBuilding && progressTimer->isActive())
+	{
+		progressTimer->stop();
+	}
+
+	const QHash<StringId, StringId> lastVolunteers = volunteers;
+	volunteers = inVolunteers;
+	for (size_t row = 0; row < rows.size(); ++row)
+	{
+		const StringId projectName = rows[row]->projectName;
+		if (lastVolunteers.value(projectName) != volunteers.value(projectName))
+		{
+			formattedRows[row].formattedColumns &= ~getColumnBit(EProjectTableColumn::Volunteer);
+			emitCellsChanged(static_cast<qint32>(row), getColumnBit(EProjectTableColumn::Volunteer));
+		}
+	}
+}
+
+const ProjectInformation* ProjectTableModel::getProject(qint32 row) const
+{
+	return row >= 0 && static_cast<size_t>(row) < rows.size() ? rows[row] : nullptr;
+}
+
+int ProjectTableModel::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : static_cast<int>(rows.size());
+}
+
+int ProjectTableModel::columnCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : static_cast<int>(EProjectTableColumn::Count);
+}
+
+QVariant ProjectTableModel::data(const QModelIndex& index, int role) const
+{
+	const ProjectInformation* info = getProject(index.row());
+	if (info == nullptr)
+	{
+		return QVariant();
+	}
+
+	const EProjectTableColumn column = static_cast<EProjectTableColumn>(index.column());
+	switch (role)
+	{
+	case Qt::DisplayRole:
+		if (column == EProjectTableColumn::History)
+		{
+			break; // Drawn by BuildHistoryDelegate, the text is only shown as tool tip.
+		}
+		return getCellText(index.row(), column);
+
+	case Qt::ToolTipRole:
+		return getCellText(index.row(), column);
+
+	case Qt::ForegroundRole:
+		if (projectInformation.isProjectStale(*info))
+		{
+			return QColor(Qt::gray);
+		}
+		break;
+
+	case Qt::DecorationRole:
+		if (column == EProjectTableColumn::Status)
+		{
+			if (const QIcon* icon = getStatusIcon(*info))
+			{
+				return *icon;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return QVariant();
+}
+
+QVariant ProjectTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+	{
+		return QVariant();
+	}
+
+	switch (static_cast<EProjectTableColumn>(section))
+	{
+	case EProjectTableColumn::Status: return "Status";
+	case EProjectTableColumn::Project: return "Project";
+	case EProjectTableColumn::RemainingTime: return "Remaining Time";
+	case EProjectTableColumn::Duration: return "Duration";
+	case EProjectTableColumn::LastSuccessfulBuild: return "Last Successful Build";
+	case EProjectTableColumn::History: return "History";
+	case EProjectTableColumn::Volunteer: return "Volunteer";
+	case EProjectTableColumn::InitiatedBy: return "Initiated By";
+	default: return QVariant();
+	}
+}
+
+const QString& ProjectTableModel::getCellText(qint32 row, EProjectTableColumn column) const
+{
+	FormattedRow& formattedRow = formattedRows[row];
+	const quint32 columnBit = 1u << static_cast<quint32>(column);
+	if ((formattedRow.formattedColumns & columnBit) == 0)
+	{
+		formattedRow.cells[static_cast<size_t>(column)] = formatCell(*rows[row], column);
+		formattedRow.formattedColumns |= columnBit;
+	}
+
+	return formattedRow.cells[static_cast<size_t>(column)];
+}
+
+QString ProjectTableModel::formatCell(const ProjectInformation& info, EProjectTableColumn column) const
+{
+	switch (column)
+	{
+	case EProjectTableColumn::Status:
+		return projectStatus_toString(info.status);
+
+	case EProjectTableColumn::Project:
+		return info.getProjectName();
+
+	case EProjectTableColumn::RemainingTime:
+	{
+		if (!info.isBuilding)
+		{
+			return "-";
+		}
+
+		qint64 remainingTime = info.estimatedRemainingTime;
+		if (info.buildStartTime != 0)
+		{
+			remainingTime = info.estimatedDuration - (QDateTime::currentMSecsSinceEpoch() - info.buildStartTime);
+		}
+
+		qint32 estimatedRemainingTime = remainingTime / 1000;
+		const char* timeUnit = "minute(s)";
+		if (estimatedRemainingTime < 60 && estimatedRemainingTime > -60)
+		{
+			timeUnit = "second(s)";
+		}
+		else
+		{
+			estimatedRemainingTime /= 60;
+		}
+
+		QString estimatedRemainingTimeFull;
+		QTextStream estimatedRemainingTimeStream(&estimatedRemainingTimeFull);
+		if (estimatedRemainingTime < 0)
+		{
+			estimatedRemainingTime = abs(estimatedRemainingTime);
+			estimatedRemainingTimeStream << "Taking " << estimatedRemainingTime << " " << timeUnit << " longer";
+		}
+		else
+		{
+			estimatedRemainingTimeStream << estimatedRemainingTime << " " << timeUnit;
+		}
+		estimatedRemainingTimeStream.flush();
+		return estimatedRemainingTimeFull;
+	}
+
+	case EProjectTableColumn::Duration:
+	{
+		qint64 inProgressFor = info.inProgressFor;
+		if (info.isBuilding && info.buildStartTime != 0)
+		{
+			inProgressFor = QDateTime::currentMSecsSinceEpoch() - info.buildStartTime;
+		}
+		return QString::number(inProgressFor / 60 / 1000) + " minutes";
+	}
+
+	case EProjectTableColumn::LastSuccessfulBuild:
+	{
+		if (info.lastSuccessfulBuildTime == -1)
+		{
+			return "Unavailable";
+		}
+
+		QDateTime lastSuccessfulBuild;
+		lastSuccessfulBuild.setMSecsSinceEpoch(info.lastSuccessfulBuildTime);
+		return lastSuccessfulBuild.toLocalTime().toString("hh:mm dd-MM-yyyy");
+	}
+
+	case EProjectTableColumn::History:
+	{
+		const ProjectBuildHistory* history = buildHistory != nullptr ? buildHistory->find(info.getKey()) : nullptr;
+		if (history == nullptr)
+		{
+			return "No builds recorded";
+		}
+
+		const size_t begin = history->lowerBound(static_cast<quint32>(QDateTime::currentSecsSinceEpoch() - HISTORY_SUMMARY_PERIOD_S));
+		size_t failures = 0;
+		for (size_t i = begin; i < history->size(); ++i)
+		{
+			failures += projectStatus_isFailure(history->getStatus(i)) ? 1 : 0;
+		}
+		return QString("Failed %1 of %2 builds in the last week").arg(failures).arg(history->size() - begin);
+	}
+
+	case EProjectTableColumn::Volunteer:
+		return StringTable::get(volunteers.value(info.projectName));
+
+	case EProjectTableColumn::InitiatedBy:
+	{
+		QString initiators;
+		for (qint32 i = 0; i < info.initiatedBy.size(); ++i)
+		{
+			if (i != 0)
+			{
+				if (i == info.initiatedBy.size() - 1)
+				{
+					initiators += " and ";
+				}
+				else
+				{
+					initiators += ", ";
+				}
+			}
+			initiators += StringTable::get(info.initiatedBy[i]);
+		}
+		return initiators;
+	}
+
+	default:
+		return QString();
+	}
+}
+
+const QIcon* ProjectTableModel::getStatusIcon(const ProjectInformation& info) const
+{
+	if (projectStatus_isFailure(info.status))
+	{
+		return info.isBuilding ? failedBuilding : failed;
+	}
+
+	return info.isBuilding ? succeededBuilding : succeeded;
+}
+
+void ProjectTableModel::emitCellsChanged(qint32 row, quint32 columns)
+{
+	// Adjacent columns are reported at once.
+	const int columnCount = static_cast<int>(EProjectTableColumn::Count);
+	for (int first = 0; first < columnCount; ++first)
+	{
+		if ((columns & (1u << first)) != 0)
+		{
+			int last = first;
+			while (last + 1 < columnCount && (columns & (1u << (last + 1))) != 0)
+			{
+				++last;
+			}
+			dataChanged(index(row, first), index(row, last));
+			first = last;
+		}
+	}
+}
+
+void ProjectTableModel::updateProgress()
+{
+	const quint32 progressColumns = getColumnBit(EProjectTableColumn::RemainingTime) | getColumnBit(EProjectTableColumn::Duration);
+	for (size_t row = 0; row < rows.size(); ++row)
+	{
+		if (rows[row]->isBuilding && rows[row]->buildStartTime != 0)
+		{
+			formattedRows[row].formattedColumns &= ~progressColumns;
+			emitCellsChanged(static_cast<qint32>(row), progressColumns);
+		}
+	}
+}
@@ -0,0 +1,93 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "ProjectSnapshot.h"
+
+#include <qabstractitemmodel.h>
+#include <qhash.h>
+
+enum class EProjectTableColumn
+{
+	Status,
+	Project,
+	RemainingTime,
+	Duration,
+	LastSuccessfulBuild,
+	History,
+	Volunteer,
+	InitiatedBy,
+	Count
+};
+
+// Presents a project snapshot as a table. A new snapshot is applied as row insertions, removals and changes
+// relative to the previous one. Cells are only formatted when the view asks for them, which is for the rows
+// in its viewport, and the text is kept until the row changes.
+class ProjectTableModel : public QAbstractTableModel
+{
+	Q_OBJECT
+
+public:
+	ProjectTableModel(QObject* parent);
+
+	void setIcons(const QIcon* inSucceeded, const QIcon* inSucceededBuilding,
+		const QIcon* inFailed, const QIcon* inFailedBuilding);
+	void setProjectInformation(const ProjectSnapshot& projectInformation, const QHash<StringId, StringId>& volunteers);
+	void setBuildHistory(const class BuildHistory* buildHistory);
+
+	// Returns nullptr for rows that don't exist.
+	const ProjectInformation* getProject(qint32 row) const;
+
+	virtual int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	virtual int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+	virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+	// Formatted text of the cells of a row, only filled in for cells that were shown since the row changed.
+	struct FormattedRow
+	{
+		FormattedRow() :
+			formattedColumns(0)
+		{
+		}
+
+		QString cells[static_cast<size_t>(EProjectTableColumn::Count)];
+		quint32 formattedColumns;
+	};
+
+	const QString& getCellText(qint32 row, EProjectTableColumn column) const;
+	QString formatCell(const ProjectInformation& info, EProjectTableColumn column) const;
+	const QIcon* getStatusIcon(const ProjectInformation& info) const;
+	void emitCellsChanged(qint32 row, quint32 columns); // Columns as a bit mask.
+	void updateProgress();
+
+	const QIcon* succeeded;
+	const QIcon* succeededBuilding;
+	const QIcon* failed;
+	const QIcon* failedBuilding;
+
+	class QTimer* progressTimer;
+	const class BuildHistory* buildHistory;
+
+	// Rows point into the snapshot, which is kept alive for that reason.
+	ProjectSnapshot projectInformation;
+	std::vector<const ProjectInformation*> rows;
+	mutable std::vector<FormattedRow> formattedRows;
+	QHash<StringId, StringId> volunteers;
+};
@@ -17,34 +17,30 @@
 
 #include "ServerOverviewTable.h"
 
-#include "ProjectInformation.h"
+#include "BuildHistoryDelegate.h"
+#include "ProjectTableModel.h"
 
-#include <qdatetime.h>
 #include <qheaderview.h>
 #include <qmenu.h>
-#include <QMouseEvent>
-#include <qtablewidget.h>
-#include <qtextstream.h>
-#include <qtooltip.h>
+
+// Rows measured besides the visible ones when a column is fitted to its contents, as every measured cell is
+// formatted.
+constexpr int RESIZE_CONTENTS_PRECISION = 100;
 
 ServerOverviewTable::ServerOverviewTable(QWidget* parent) :
-	QTableWidget(parent),
-	succeeded(nullptr),
-	succeededBuilding(nullptr),
-	failed(nullptr),
-	failedBuilding(nullptr),
-	projectInformation(nullptr)
+	QTableView(parent),
+	projectTableModel(new ProjectTableModel(this)),
+	buildHistoryDelegate(new BuildHistoryDelegate(this)),
+	changedColumns(static_cast<size_t>(EProjectTableColumn::Count), false)
 {
-	headerLabels.push_back("Status");
-	headerLabels.push_back("Project");
-	headerLabels.push_back("Remaining Time");
-	headerLabels.push_back("Duration");
-	headerLabels.push_back("Last Successful Build");
-	headerLabels.push_back("Volunteer");
-	headerLabels.push_back("Initiated By");
+	setModel(projectTableModel);
+	setItemDelegateForColumn(static_cast<int>(EProjectTableColumn::History), buildHistoryDelegate);
+	horizontalHeader()->setSectionResizeMode(static_cast<int>(EProjectTableColumn::InitiatedBy), QHeaderView::Stretch);
+	horizontalHeader()->setResizeContentsPrecision(RESIZE_CONTENTS_PRECISION);
 
-	setColumnCount(headerLabels.size());
-	setHorizontalHeaderLabels(headerLabels);
+	connect(projectTableModel, &ProjectTableModel::dataChanged, this, &ServerOverviewTable::onDataChanged);
+	connect(projectTableModel, &ProjectTableModel::rowsInserted, this, &ServerOverviewTable::onRowsChanged);
+	connect(projectTableModel, &ProjectTableModel::rowsRemoved, this, &ServerOverviewTable::onRowsChanged);
 
 	setContextMenuPolicy(Qt::CustomContextMenu);
 	connect(this, &ServerOverviewTable::customContextMenuRequested, this, &ServerOverviewTable::openContextMenu);
@@ -53,145 +49,24 @@ ServerOverviewTable::ServerOverviewTable(QWidget* parent) :
 void ServerOverviewTable::setIcons(const QIcon* inSucceeded, const QIcon* inSucceededBuilding,
 	const QIcon* inFailed, const QIcon* inFailedBuilding)
 {
-	succeeded = inSucceeded;
-	succeededBuilding = inSucceededBuilding;
-	failed = inFailed;
-	failedBuilding = inFailedBuilding;
+	projectTableModel->setIcons(inSucceeded, inSucceededBuilding, inFailed, inFailedBuilding);
 }
 
-void ServerOverviewTable::setProjectInformation(const class std::vector<class ProjectInformation>& inProjectInformation)
+void ServerOverviewTable::setProjectInformation(const ProjectSnapshot& projectInformation, const QHash<StringId, StringId>& volunteers)
 {
-	projectInformation = &inProjectInformation;
-
-	for (auto& item : itemPool)
-	{
-		delete item;
-	}
-	itemPool.clear();
-	clearContents();
-
-	for (const ProjectInformation& info : inProjectInformation)
-	{
-		QTableWidgetItem* statusItem = new QTableWidgetItem();
-		statusItem->setText(projectStatus_toString(info.status));
-		if (projectStatus_isFailure(info.status))
-		{
-			if (info.isBuilding && failedBuilding != nullptr)
-			{
-				statusItem->setIcon(*failedBuilding);
-			}
-			else if (!info.isBuilding && failed != nullptr)
-			{
-				statusItem->setIcon(*failed);
-			}
-		}
-		else
-		{
-			if (info.isBuilding && succeededBuilding != nullptr)
-			{
-				statusItem->setIcon(*succeededBuilding);
-			}
-			else if (!info.isBuilding && succeeded != nullptr)
-			{
-				statusItem->setIcon(*succeeded);
-			}
-		}
-		itemPool.push_back(statusItem);
-
-		itemPool.push_back(new QTableWidgetItem(info.projectName));
-
-		if (info.isBuilding)
-		{
-			qint32 estimatedRemainingTime = info.estimatedRemainingTime / 1000;
-			const char* timeUnit = "minute(s)";
-			if (estimatedRemainingTime < 60 && estimatedRemainingTime > -60)
-			{
-				timeUnit = "second(s)";
-			}
-			else
-			{
-				estimatedRemainingTime /= 60;
-			}
-
-			QString estimatedRemainingTimeFull;
-			QTextStream estimatedRemainingTimeStream(&estimatedRemainingTimeFull);
-			if (estimatedRemainingTime < 0)
-			{
-				estimatedRemainingTime = abs(estimatedRemainingTime);
-				estimatedRemainingTimeStream << "Taking " << estimatedRemainingTime << " " << timeUnit << " longer";
-			}
-			else
-			{
-				estimatedRemainingTimeStream << estimatedRemainingTime << " " << timeUnit;
-			}
-			estimatedRemainingTimeStream.flush();
-
-			itemPool.push_back(new QTableWidgetItem(estimatedRemainingTimeFull));
-		}
-		else
-		{
-			itemPool.push_back(new QTableWidgetItem("-"));
-		}
-		itemPool.push_back(new QTableWidgetItem(QString::number(info.inProgressFor / 60 / 1000) + " minutes"));
-
-		if (info.lastSuccessfulBuildTime != -1)
-		{
-			QDateTime lastSuccessfulBuild;
-			lastSuccessfulBuild.setMSecsSinceEpoch(info.lastSuccessfulBuildTime);
-			itemPool.push_back(new QTableWidgetItem(lastSuccessfulBuild.toLocalTime().toString("hh:mm dd-MM-yyyy")));
-		}
-		else
-		{
-			itemPool.push_back(new QTableWidgetItem("Unavailable"));
-		}
-
-		itemPool.push_back(new QTableWidgetItem(info.volunteer));
-
-		QString initiators;
-		for (size_t i = 0; i < info.initiatedBy.size(); ++i)
-		{
-			if (i != 0)
-			{
-				if (i == info.initiatedBy.size() - 1)
-				{
-					initiators += " and ";
-				}
-				else
-				{
-					initiators += ", ";
-				}
-			}
-			initiators += info.initiatedBy[i];
-		}
-
-		itemPool.push_back(new QTableWidgetItem(initiators));
-	}
-
-	const qint32 numProjects = static_cast<qint32>(inProjectInformation.size());
-	setRowCount(numProjects);
-	const qint32 numHeaders = headerLabels.size();
-	for (qint32 row = 0; row < numProjects; ++row)
-	{
-		for (qint32 column = 0; column < numHeaders; ++column)
-		{
-			const qint32 itemLocationInArray = row * numHeaders + column;
-			QTableWidgetItem* item = itemPool[itemLocationInArray];
-			item->setToolTip(item->text());
-			setItem(row, column, item);
-		}
-	}
+	projectTableModel->setProjectInformation(projectInformation, volunteers);
+	resizeChangedColumns();
+}
 
-	resizeColumnsToContents();
-	horizontalHeader()->setSectionResizeMode(headerLabels.size() - 1, QHeaderView::Stretch);
+void ServerOverviewTable::setBuildHistory(const BuildHistory* buildHistory)
+{
+	buildHistoryDelegate->setBuildHistory(buildHistory);
+	projectTableModel->setBuildHistory(buildHistory);
 }
 
-QString ServerOverviewTable::getProjectName(qint32 row)
+const ProjectInformation* ServerOverviewTable::getProject(qint32 row) const
 {
-	if (row == -1)
-	{
-		return "";
-	}
-	return item(row, 1)->text();
+	return projectTableModel->getProject(row);
 }
 
 void ServerOverviewTable::openContextMenu(const QPoint& location)
@@ -200,37 +75,53 @@ void ServerOverviewTable::openContextMenu(const QPoint& location)
 
 	QMenu contextMenu;
 
+	const ProjectInformation* info = projectTableModel->getProject(currentIndex().row());
+
 	QAction* volunteerToFixAction = contextMenu.addAction("Volunteer to Fix");
-	QString projectName = getProjectName(currentIndex().row());
-	bool volunteerOptionEnabled = false;
-	if (projectInformation)
-	{
-		const std::vector<ProjectInformation>::const_iterator pos = std::find_if(projectInformation->begin(), projectInformation->end(),
-			[&projectName](const ProjectInformation& projectInformation) { return projectInformation.projectName == projectName; });
-		volunteerOptionEnabled = pos != projectInformation->end() && projectStatus_isFailure(pos->status);
-	}
-	volunteerToFixAction->setEnabled(volunteerOptionEnabled);
+	volunteerToFixAction->setEnabled(info != nullptr && projectStatus_isFailure(info->status));
 
 	QAction* viewBuildLogAction = contextMenu.addAction("View Build Log");
-	bool viewBuildLogActionEnabled = false;
-	if (projectInformation)
-	{
-		const std::vector<ProjectInformation>::const_iterator pos = std::find_if(projectInformation->begin(), projectInformation->end(),
-			[&projectName](const ProjectInformation& projectInformation) { return projectInformation.projectName == projectName; });
-		viewBuildLogActionEnabled = pos != projectInformation->end() && pos->buildNumber != 0;
-	}
-	viewBuildLogAction->setEnabled(viewBuildLogActionEnabled);
+	viewBuildLogAction->setEnabled(info != nullptr && info->buildNumber != 0);
+
+	// A refresh while the menu is open replaces the model's snapshot.
+	const ProjectInformation project = info != nullptr ? *info : ProjectInformation();
 
 	const QAction* selectedContextMenuItem = contextMenu.exec(globalLocation);
 	if (selectedContextMenuItem)
 	{
 		if (selectedContextMenuItem == volunteerToFixAction)
 		{
-			volunteerToFix(getProjectName(currentIndex().row()));
+			volunteerToFix(project);
 		}
 		else if (selectedContextMenuItem == viewBuildLogAction)
 		{
-			viewBuildLog(getProjectName(currentIndex().row()));
+			viewBuildLog(project);
+		}
+	}
+}
+
+void ServerOverviewTable::onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+	for (int column = topLeft.column(); column <= bottomRight.column(); ++column)
+	{
+		changedColumns[column] = true;
+	}
+}
+
+void ServerOverviewTable::onRowsChanged()
+{
+	std::fill(changedColumns.begin(), changedColumns.end(), true);
+}
+
+void ServerOverviewTable::resizeChangedColumns()
+{
+	// The last column stretches over the remaining width.
+	for (int column = 0; column < static_cast<int>(EProjectTableColumn::InitiatedBy); ++column)
+	{
+		if (changedColumns[column])
+		{
+			resizeColumnToContents(column);
 		}
 	}
+	std::fill(changedColumns.begin(), changedColumns.end(), false);
 }
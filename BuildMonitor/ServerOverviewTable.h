@@ -17,10 +17,12 @@
 
 #pragma once
 
-#include <qstandarditemmodel.h>
-#include <qtablewidget.h>
+#include "ProjectSnapshot.h"
 
-class ServerOverviewTable : public QTableWidget
+#include <qhash.h>
+#include <qtableview.h>
+
+class ServerOverviewTable : public QTableView
 {
 	Q_OBJECT
 
@@ -29,23 +31,22 @@ public:
 
 	void setIcons(const QIcon* inSucceeded, const QIcon* inSucceededBuilding,
 		const QIcon* inFailed, const QIcon* inFailedBuilding);
-	void setProjectInformation(const class std::vector<class ProjectInformation>& inProjectInformation);
+	void setProjectInformation(const ProjectSnapshot& projectInformation, const QHash<StringId, StringId>& volunteers);
+	void setBuildHistory(const class BuildHistory* buildHistory);
 
-	QString getProjectName(qint32 row);
+	const ProjectInformation* getProject(qint32 row) const;
 
 Q_SIGNALS:
-	void volunteerToFix(const QString& projectName);
-	void viewBuildLog(const QString& projectName);
+	void volunteerToFix(const ProjectInformation& info);
+	void viewBuildLog(const ProjectInformation& info);
 
 private:
 	void openContextMenu(const QPoint& location);
+	void onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+	void onRowsChanged();
+	void resizeChangedColumns();
 
-	const QIcon* succeeded;
-	const QIcon* succeededBuilding;
-	const QIcon* failed;
-	const QIcon* failedBuilding;
-
-	const class std::vector<class ProjectInformation>* projectInformation;
-	std::vector<class QTableWidgetItem*> itemPool;
-	QStringList headerLabels;
+	class ProjectTableModel* projectTableModel;
+	class BuildHistoryDelegate* buildHistoryDelegate;
+	std::vector<bool> changedColumns; // Columns of which the width may have to change.
 };
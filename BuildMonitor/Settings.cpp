@@ -28,6 +28,8 @@ Settings::Settings(QObject* parent) :
 	projectSettingsFolder(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)),
 	fixServerAddress("jenkins:1080"),
 	refreshIntervalInSeconds(60),
+	maxRequestsPerServer(4),
+	usePushUpdates(false),
 	showDisabledProjects(false),
 	useRegExProjectFilter(false),
 	projectIncludeRegEx(".*"),
@@ -93,6 +95,18 @@ bool Settings::loadSettings()
 		refreshIntervalInSeconds = refreshIntervalInSecondsValue.toDouble();
 	}
 
+	QJsonValue maxRequestsPerServerValue = root.value("maxRequestsPerServer");
+	if (maxRequestsPerServerValue.isDouble())
+	{
+		maxRequestsPerServer = maxRequestsPerServerValue.toDouble();
+	}
+
+	QJsonValue usePushUpdatesValue = root.value("usePushUpdates");
+	if (usePushUpdatesValue.isBool())
+	{
+		usePushUpdates = usePushUpdatesValue.toBool();
+	}
+
 	QJsonValue showDisabledProjectsValue = root.value("showDisabledProjects");
 	if (showDisabledProjectsValue.isBool())
 	{
@@ -207,6 +221,10 @@ void Settings::saveSettings()
 
 	root.insert("refreshIntervalInSeconds", refreshIntervalInSeconds);
 
+	root.insert("maxRequestsPerServer", maxRequestsPerServer);
+
+	root.insert("usePushUpdates", usePushUpdates);
+
 	root.insert("showDisabledProjects", showDisabledProjects);
 
 	root.insert("useRegExProjectFilter", useRegExProjectFilter);
@@ -37,6 +37,8 @@ public:
 	QString fixServerAddress;
 	std::vector<QString> ignoreUserList;
 	qint32 refreshIntervalInSeconds;
+	qint32 maxRequestsPerServer;
+	bool usePushUpdates; // Requires the SSE Gateway plugin on the servers.
 	bool showDisabledProjects;
 	bool useRegExProjectFilter;
 	QRegExp projectIncludeRegEx;
@@ -41,6 +41,8 @@ SettingsDialog::SettingsDialog(QWidget* parent, class Settings& inSettings) :
 	}
 	ui.nameIgnoreList->setText(ignoreUserList);
 	ui.refreshInterval->setValue(inSettings.refreshIntervalInSeconds);
+	ui.maxRequestsPerServer->setValue(inSettings.maxRequestsPerServer);
+	ui.usePushUpdates->setChecked(inSettings.usePushUpdates);
 	ui.useRegExProjectFilter->setChecked(inSettings.useRegExProjectFilter);
 	ui.projectIncludeRegExp->setText(inSettings.projectIncludeRegEx.pattern());
 	ui.projectExcludeRegExp->setText(inSettings.projectExcludeRegEx.pattern());
@@ -74,6 +76,8 @@ void SettingsDialog::onButtonClicked(QAbstractButton* button)
 			settings.ignoreUserList.emplace_back(user.trimmed());
 		}
 		settings.refreshIntervalInSeconds = ui.refreshInterval->value();
+		settings.maxRequestsPerServer = ui.maxRequestsPerServer->value();
+		settings.usePushUpdates = ui.usePushUpdates->isChecked();
 		settings.useRegExProjectFilter = ui.useRegExProjectFilter->isChecked();
 		settings.projectIncludeRegEx.setPattern(ui.projectIncludeRegExp->text());
 		settings.projectExcludeRegEx.setPattern(ui.projectExcludeRegExp->text());
@@ -0,0 +1,88 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StringTable.h"
+
+StringTable::StringTable() :
+	chunks(),
+	count(1)
+{
+	chunks[0] = new QString[CHUNK_SIZE];
+	ids.insert(QString(), 0);
+}
+
+StringTable::~StringTable()
+{
+	for (QString* chunk : chunks)
+	{
+		delete[] chunk;
+	}
+}
+
+StringTable& StringTable::instance()
+{
+	static StringTable stringTable;
+	return stringTable;
+}
+
+StringId StringTable::intern(const QString& string)
+{
+	StringTable& table = instance();
+	table.mutex.lock();
+	StringId id = table.count.loadAcquire();
+	const QHash<QString, StringId>::const_iterator pos = table.ids.constFind(string);
+	if (pos != table.ids.constEnd())
+	{
+		id = pos.value();
+	}
+	else if (id < CHUNK_SIZE * MAXIMUM_CHUNKS)
+	{
+		QString*& chunk = table.chunks[id / CHUNK_SIZE];
+		if (chunk == nullptr)
+		{
+			chunk = new QString[CHUNK_SIZE];
+		}
+		chunk[id % CHUNK_SIZE] = string;
+		table.ids.insert(string, id);
+		table.count.storeRelease(id + 1);
+	}
+	else
+	{
+		id = 0; // Full, which takes more names than any set of servers has.
+	}
+	table.mutex.unlock();
+	return id;
+}
+
+StringId StringTable::find(const QString& string)
+{
+	StringTable& table = instance();
+	table.mutex.lock();
+	const StringId id = table.ids.value(string, 0);
+	table.mutex.unlock();
+	return id;
+}
+
+const QString& StringTable::get(StringId id)
+{
+	const StringTable& table = instance();
+	if (id >= table.count.loadAcquire())
+	{
+		id = 0;
+	}
+	return table.chunks[id / CHUNK_SIZE][id % CHUNK_SIZE];
+}
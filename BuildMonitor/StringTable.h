@@ -0,0 +1,56 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <qatomic.h>
+#include <qhash.h>
+#include <qmutex.h>
+#include <qstring.h>
+
+typedef quint32 StringId;
+
+// Stores every distinct project, user and server name once for the lifetime of the application, so project
+// information only has to hold and copy integers. Id 0 is the empty string. Safe to use from any thread, get
+// doesn't lock because it is called for every name that is painted.
+class StringTable
+{
+public:
+	static StringId intern(const QString& string);
+
+	// Returns 0 for strings that were never interned, without adding them.
+	static StringId find(const QString& string);
+
+	static const QString& get(StringId id);
+
+private:
+	static constexpr quint32 CHUNK_SIZE = 4096;
+	static constexpr quint32 MAXIMUM_CHUNKS = 4096;
+
+	StringTable();
+	~StringTable();
+
+	static StringTable& instance();
+
+	// Strings are stored in chunks that are never moved, so references to them stay valid. A string is
+	// complete before the count is raised past it, ids below the count can be read without the mutex.
+	QString* chunks[MAXIMUM_CHUNKS];
+	QAtomicInteger<quint32> count;
+
+	QMutex mutex; // Guards adding strings and the ids.
+	QHash<QString, StringId> ids;
+};
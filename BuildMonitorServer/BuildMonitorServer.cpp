@@ -19,9 +19,9 @@
 
 #include "FixOverviewTable.h"
 
-BuildMonitorServer::BuildMonitorServer(QWidget *parent) :
+BuildMonitorServer::BuildMonitorServer(qint32 workerCount, QWidget *parent) :
 	QMainWindow(parent),
-	server(this)
+	server(this, workerCount)
 {
 	ui.setupUi(this);
 
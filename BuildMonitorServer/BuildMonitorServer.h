@@ -28,7 +28,7 @@ class BuildMonitorServer : public QMainWindow
 	Q_OBJECT
 
 public:
-	BuildMonitorServer(QWidget *parent = Q_NULLPTR);
+	BuildMonitorServer(qint32 workerCount, QWidget *parent = Q_NULLPTR);
 
 private:
 	void onFixInfoChanged(const std::vector<FixInfo>& fixInfo);
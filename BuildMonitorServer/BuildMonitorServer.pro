@@ -8,22 +8,33 @@ QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+# Functor based QMetaObject::invokeMethod is used.
+lessThan(QT_MAJOR_VERSION, 5)|if(equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 10)) {
+    error("Qt 5.10 or newer is required.")
+}
+
 TARGET = BuildMonitorServer
 TEMPLATE = app
 
 unix:QMAKE_CXXFLAGS += -std=c++11
 
+INCLUDEPATH += ../Shared
+
 SOURCES += main.cpp\
-    AcceptThread.cpp \
     BuildMonitorServer.cpp \
+    ConnectionWorker.cpp \
     Server.cpp \
-    FixOverviewTable.cpp
+    FixOverviewTable.cpp \
+    ../Shared/FixMessage.cpp \
+    ../Shared/MessageFraming.cpp
 
-HEADERS  += AcceptThread.h \
-    BuildMonitorServer.h \
+HEADERS  += BuildMonitorServer.h \
+    ConnectionWorker.h \
     FixInfo.h \
     Server.h \
-    FixOverviewTable.h
+    FixOverviewTable.h \
+    ../Shared/FixMessage.h \
+    ../Shared/MessageFraming.h
 
 RESOURCES += \
     BuildMonitorServer.qrc
@@ -0,0 +1,264 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ConnectionWorker.h"
+
+#include "Server.h"
+
+#include <qjsondocument.h>
+#include <qtcpsocket.h>
+#include <qtimer.h>
+
+constexpr qint32 CONNECTION_TIMEOUT_MS = 3000;
+constexpr qint32 PERSISTENT_PROTOCOL_VERSION = 2;
+
+ConnectionWorker::ConnectionWorker(Server& inServer) :
+	QObject(nullptr),
+	server(inServer)
+{
+}
+
+void ConnectionWorker::addConnection(qintptr socketDescriptor)
+{
+	QTcpSocket* socket = new QTcpSocket(this);
+	if (!socket->setSocketDescriptor(socketDescriptor))
+	{
+		delete socket;
+		return;
+	}
+
+	// Clients that never send their request don't keep the socket open.
+	QTimer* timeoutTimer = new QTimer(socket);
+	timeoutTimer->setSingleShot(true);
+	connect(timeoutTimer, &QTimer::timeout, socket, &QAbstractSocket::abort);
+	timeoutTimer->start(CONNECTION_TIMEOUT_MS);
+
+	Connection& connection = connections[socket];
+	connection.isPersistent = false;
+	connection.timeoutTimer = timeoutTimer;
+
+	connect(socket, &QIODevice::readyRead, this, [this, socket]() { onReadyRead(socket); });
+	// Queued, as disconnecting can emit it while the connection is still being processed.
+	connect(socket, &QAbstractSocket::disconnected, this, [this, socket]() { onDisconnected(socket); }, Qt::QueuedConnection);
+}
+
+void ConnectionWorker::onReadyRead(QTcpSocket* socket)
+{
+	Connection& connection = connections[socket];
+	connection.reader.readFrom(*socket);
+
+	QByteArray message;
+	if (!connection.isPersistent && connection.reader.nextUnframedMessage(message))
+	{
+		processMessage(socket, connection, message);
+	}
+
+	if (connection.isPersistent)
+	{
+		while (connection.reader.nextFrame(message))
+		{
+			if (!processFrame(socket, connection, message))
+			{
+				// Without knowing what the message referred to, the dictionaries can't be kept in sync.
+				socket->abort();
+				return;
+			}
+		}
+	}
+
+	if (connection.reader.hasError())
+	{
+		socket->abort();
+	}
+}
+
+void ConnectionWorker::onDisconnected(QTcpSocket* socket)
+{
+	connections.erase(socket);
+	socket->deleteLater();
+}
+
+void ConnectionWorker::processMessage(QTcpSocket* socket, Connection& connection, const QByteArray& message)
+{
+	const QJsonDocument json = QJsonDocument::fromBinaryData(message);
+	const QJsonObject root = json.object();
+	if (root["version"].toInt() != 1)
+	{
+		socket->disconnectFromHost();
+		return;
+	}
+
+	const QString requestType = root["request_type"].toString();
+	const QJsonObject requestInfo = root["request_info"].toObject();
+	if (requestType == "hello" && requestInfo["version"].toInt() >= PERSISTENT_PROTOCOL_VERSION)
+	{
+		QJsonObject response;
+		response["version"] = 1;
+		response["response_type"] = "hello";
+		QJsonObject responseInfo;
+		responseInfo["version"] = PERSISTENT_PROTOCOL_VERSION;
+		response["response_info"] = responseInfo;
+
+		QJsonDocument document;
+		document.setObject(response);
+		socket->write(document.toBinaryData());
+
+		connection.isPersistent = true;
+		connection.timeoutTimer->stop();
+		socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+		return;
+	}
+
+	QJsonArray responseInfo;
+	if (handleRequest(requestType, requestInfo, responseInfo) && requestType == "fix_state")
+	{
+		QJsonObject response;
+		response["version"] = 1;
+		response["response_type"] = "fix_state";
+		response["response_info"] = responseInfo;
+
+		QJsonDocument document;
+		document.setObject(response);
+		socket->write(document.toBinaryData());
+	}
+
+	socket->disconnectFromHost();
+}
+
+bool ConnectionWorker::processFrame(QTcpSocket* socket, Connection& connection, const QByteArray& message)
+{
+	FixMessageReader reader(connection.dictionary, message);
+	quint32 requestId = 0;
+	EFixMessageType type = EFixMessageType::Error;
+	if (!reader.readHeader(requestId, type))
+	{
+		return false;
+	}
+
+	Server::FixChanges changes = {};
+	switch (type)
+	{
+	case EFixMessageType::FixState:
+	{
+		quint64 knownVersion = 0;
+		if (!reader.readUnsigned(knownVersion))
+		{
+			return false;
+		}
+
+		changes = server.getChangesSince(knownVersion);
+		break;
+	}
+	case EFixMessageType::ReportFixing:
+	{
+		FixInfo fixInfo;
+		if (!reader.readString(fixInfo.projectName) || !reader.readString(fixInfo.userName) ||
+			!reader.readInteger(fixInfo.buildNumber))
+		{
+			return false;
+		}
+
+		emit fixStarted(fixInfo);
+		break;
+	}
+	case EFixMessageType::MarkFixed:
+	{
+		QString projectName;
+		qint32 buildNumber = 0;
+		if (!reader.readString(projectName) || !reader.readInteger(buildNumber))
+		{
+			return false;
+		}
+
+		emit markFixed(projectName, buildNumber);
+		break;
+	}
+	case EFixMessageType::Error:
+		break;
+	}
+
+	if (!reader.isAtEnd())
+	{
+		return false;
+	}
+
+	// Every request is answered, so the client can retire it.
+	FixMessageWriter writer(connection.dictionary, requestId, type);
+	if (type == EFixMessageType::FixState)
+	{
+		writer.writeUnsigned(changes.version);
+		writer.writeUnsigned(changes.isFullState ? 1 : 0);
+		writer.writeCount(static_cast<quint32>(changes.startedFixes.size()));
+		for (const FixInfo& info : changes.startedFixes)
+		{
+			writer.writeString(info.projectName);
+			writer.writeString(info.userName);
+			writer.writeInteger(info.buildNumber);
+		}
+		writer.writeCount(static_cast<quint32>(changes.finishedFixes.size()));
+		for (const QString& projectName : changes.finishedFixes)
+		{
+			writer.writeString(projectName);
+		}
+	}
+
+	writeMessageFrame(*socket, writer.getMessage());
+	return true;
+}
+
+bool ConnectionWorker::handleRequest(const QString& requestType, const QJsonObject& requestInfo, QJsonArray& responseInfo)
+{
+	if (requestType == "report_fixing")
+	{
+		const FixInfo fixInfo = {
+			requestInfo["project_name"].toString(),
+			requestInfo["user_name"].toString(),
+			requestInfo["build_number"].toInt()
+		};
+
+		emit fixStarted(fixInfo);
+	}
+	else if (requestType == "fix_state")
+	{
+		const QJsonArray projectsArray = requestInfo["projects"].toArray();
+		std::vector<QString> projects;
+		for (const QJsonValue& element : projectsArray)
+		{
+			projects.emplace_back(element.toString());
+		}
+
+		const std::vector<FixInfo> state = server.getProjectsState(projects);
+		for (const FixInfo& info : state)
+		{
+			QJsonObject fixStateObject;
+			fixStateObject["project_name"] = info.projectName;
+			fixStateObject["user_name"] = info.userName;
+			fixStateObject["build_number"] = info.buildNumber;
+			responseInfo.push_back(fixStateObject);
+		}
+	}
+	else if (requestType == "mark_fixed")
+	{
+		emit markFixed(requestInfo["project_name"].toString(), requestInfo["build_number"].toInt());
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,69 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "FixInfo.h"
+#include "FixMessage.h"
+#include "MessageFraming.h"
+
+#include <qjsonarray.h>
+#include <qjsonobject.h>
+#include <qobject.h>
+
+#include <map>
+
+// Handles the connections assigned to it on its own event loop thread. The server owns a fixed set of these,
+// so no thread is created per connection.
+//
+// A connection starts out speaking version 1, a single request per connection. A client that says hello
+// with version 2 keeps the connection open and sends any number of length-prefixed requests in the compact
+// format of FixMessage.h, which are answered with their request ID.
+class ConnectionWorker : public QObject
+{
+	Q_OBJECT
+
+public:
+	ConnectionWorker(class Server& inServer);
+
+	// Takes over the socket, must be called on the thread of the worker.
+	void addConnection(qintptr socketDescriptor);
+
+Q_SIGNALS:
+	void fixStarted(const FixInfo& fixInfo);
+	void markFixed(const QString& projectName, const qint32 buildNumber);
+
+private:
+	struct Connection
+	{
+		MessageFrameReader reader;
+		FixMessageDictionary dictionary;
+		bool isPersistent;
+		class QTimer* timeoutTimer;
+	};
+
+	void onReadyRead(class QTcpSocket* socket);
+	void onDisconnected(class QTcpSocket* socket);
+	void processMessage(class QTcpSocket* socket, Connection& connection, const QByteArray& message);
+	bool processFrame(class QTcpSocket* socket, Connection& connection, const QByteArray& message);
+
+	// Handles version 1 requests. Returns false for unknown request types, only fix_state fills in response info.
+	bool handleRequest(const QString& requestType, const QJsonObject& requestInfo, QJsonArray& responseInfo);
+
+	class Server& server;
+	std::map<class QTcpSocket*, Connection> connections;
+};
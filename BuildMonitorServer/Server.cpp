@@ -17,19 +17,58 @@
 
 #include "Server.h"
 
-#include "AcceptThread.h"
+#include "ConnectionWorker.h"
 
-Server::Server(QObject* parent) :
-	QTcpServer(parent)
+#include <qdatetime.h>
+#include <qset.h>
+#include <qthread.h>
+
+constexpr size_t MAX_CHANGE_LOG_SIZE = 1024;
+
+Server::Server(QObject* parent, qint32 workerCount) :
+	QTcpServer(parent),
+	// Versions continue from the time of startup, so versions known from before a restart are never mistaken
+	// for current ones.
+	fixVersion(QDateTime::currentMSecsSinceEpoch()),
+	oldestChangeVersion(fixVersion),
+	nextWorker(0)
 {
 	qRegisterMetaType<FixInfo>();
+
+	if (workerCount <= 0)
+	{
+		workerCount = std::max(QThread::idealThreadCount(), 1);
+	}
+
+	for (qint32 i = 0; i < workerCount; ++i)
+	{
+		QThread* thread = new QThread(this);
+		thread->setObjectName(QString("ConnectionWorkerThread%1").arg(i));
+
+		ConnectionWorker* worker = new ConnectionWorker(*this);
+		worker->moveToThread(thread);
+		connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+		connect(worker, &ConnectionWorker::fixStarted, this, &Server::onFixStarted);
+		connect(worker, &ConnectionWorker::markFixed, this, &Server::onMarkFixed);
+
+		thread->start();
+		workerThreads.push_back(thread);
+		workers.push_back(worker);
+	}
 }
 
 Server::~Server()
 {
-	for (AcceptThread* element : threads)
+	close();
+
+	for (QThread* thread : workerThreads)
 	{
-		element->wait(10000);
+		thread->quit();
+	}
+
+	for (QThread* thread : workerThreads)
+	{
+		thread->wait(10000);
 	}
 }
 
@@ -57,14 +96,53 @@ std::vector<FixInfo> Server::getProjectsState(const std::vector<QString>& projec
 	return result;
 }
 
+Server::FixChanges Server::getChangesSince(quint64 knownVersion)
+{
+	FixChanges changes;
+
+	fixInfoLock.lock();
+
+	changes.version = fixVersion;
+	changes.isFullState = knownVersion < oldestChangeVersion || knownVersion > fixVersion;
+	if (changes.isFullState)
+	{
+		changes.startedFixes = fixInfos;
+	}
+	else
+	{
+		// Only the last change of a project matters.
+		QSet<QString> changedProjects;
+		for (std::deque<FixChange>::const_reverse_iterator it = changeLog.crbegin();
+			it != changeLog.crend() && it->version > knownVersion; ++it)
+		{
+			if (changedProjects.contains(it->fixInfo.projectName))
+			{
+				continue;
+			}
+
+			changedProjects.insert(it->fixInfo.projectName);
+			if (it->isFinished)
+			{
+				changes.finishedFixes.push_back(it->fixInfo.projectName);
+			}
+			else
+			{
+				changes.startedFixes.push_back(it->fixInfo);
+			}
+		}
+	}
+
+	fixInfoLock.unlock();
+
+	return changes;
+}
+
 void Server::incomingConnection(qintptr socketDescriptor)
 {
-	AcceptThread* thread = new AcceptThread(socketDescriptor, *this, this);
-	connect(thread, &AcceptThread::fixStarted, this, &Server::onFixStarted);
-	connect(thread, &AcceptThread::markFixed, this, &Server::onMarkFixed);
-	connect(thread, &AcceptThread::finished, this, &Server::onThreadFinished);
-	thread->start();
-	threads.push_back(thread);
+	ConnectionWorker* worker = workers[nextWorker];
+	nextWorker = (nextWorker + 1) % workers.size();
+
+	QMetaObject::invokeMethod(worker, [worker, socketDescriptor]() { worker->addConnection(socketDescriptor); });
 }
 
 void Server::onFixStarted(const FixInfo& fixInfo)
@@ -81,6 +159,7 @@ void Server::onFixStarted(const FixInfo& fixInfo)
 	{
 		fixInfos.emplace_back(fixInfo);
 	}
+	recordChange(fixInfo, false);
 
 	emit fixInfoChanged(fixInfos);
 
@@ -95,6 +174,7 @@ void Server::onMarkFixed(const QString& projectName, const qint32 buildNumber)
 		[&projectName, &buildNumber](const FixInfo& info) { return info.projectName == projectName && info.buildNumber < buildNumber; });
 	if (foundElement != fixInfos.end())
 	{
+		recordChange(*foundElement, true);
 		fixInfos.erase(foundElement);
 	}
 
@@ -103,10 +183,12 @@ void Server::onMarkFixed(const QString& projectName, const qint32 buildNumber)
 	fixInfoLock.unlock();
 }
 
-void Server::onThreadFinished()
+void Server::recordChange(const FixInfo& fixInfo, bool isFinished)
 {
-	threads.erase(std::remove_if(threads.begin(), threads.end(), [](const AcceptThread* element)
+	changeLog.push_back({ ++fixVersion, fixInfo, isFinished });
+	if (changeLog.size() > MAX_CHANGE_LOG_SIZE)
 	{
-		return element->isFinished();
-	}), threads.end());
+		oldestChangeVersion = changeLog.front().version;
+		changeLog.pop_front();
+	}
 }
@@ -22,15 +22,27 @@
 #include <qmutex.h>
 #include <qtcpserver.h>
 
+#include <deque>
+
 class Server : public QTcpServer
 {
 	Q_OBJECT
 
 public:
-	Server(QObject* parent);
+	struct FixChanges
+	{
+		quint64 version;
+		bool isFullState; // The known version was too old, the fixes replace what the client knew.
+		std::vector<FixInfo> startedFixes;
+		std::vector<QString> finishedFixes;
+	};
+
+	// Connections are spread over a fixed number of worker threads, the ideal thread count if zero.
+	Server(QObject* parent, qint32 workerCount = 0);
 	~Server();
 
 	std::vector<FixInfo> getProjectsState(const std::vector<QString>& projects);
+	FixChanges getChangesSince(quint64 knownVersion);
 
 Q_SIGNALS:
 	void fixInfoChanged(const std::vector<FixInfo>& fixInfos);
@@ -41,9 +53,25 @@ protected:
 private:
 	void onFixStarted(const struct FixInfo& fixInfo);
 	void onMarkFixed(const QString& projectName, const qint32 buildNumber);
-	void onThreadFinished();
+	void recordChange(const FixInfo& fixInfo, bool isFinished);
+
+	struct FixChange
+	{
+		quint64 version;
+		FixInfo fixInfo;
+		bool isFinished;
+	};
 
 	QMutex fixInfoLock;
 	std::vector<FixInfo> fixInfos;
-	std::vector<class AcceptThread*> threads;
+
+	// Every change of the fix table gets the next version, so clients only retrieve the changes since the
+	// version they know. The log is bounded, clients that fall further behind get the full table.
+	quint64 fixVersion;
+	quint64 oldestChangeVersion;
+	std::deque<FixChange> changeLog;
+
+	std::vector<class QThread*> workerThreads;
+	std::vector<class ConnectionWorker*> workers;
+	size_t nextWorker;
 };
@@ -18,10 +18,19 @@
 #include "BuildMonitorServer.h"
 #include <QtWidgets/QApplication>
 
+#include <qcommandlineparser.h>
+
 int main(int argc, char *argv[])
 {
 	QApplication a(argc, argv);
-	BuildMonitorServer w;
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	const QCommandLineOption workersOption("workers", "Number of threads handling connections, the ideal thread count by default.", "count", "0");
+	parser.addOption(workersOption);
+	parser.process(a);
+
+	BuildMonitorServer w(parser.value(workersOption).toInt());
 	w.show();
 	return a.exec();
 }
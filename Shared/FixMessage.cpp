@@ -0,0 +1,191 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FixMessage.h"
+
+// Bounds the memory a peer can make the other side spend, strings beyond it are always sent in full.
+constexpr quint32 MAX_DICTIONARY_SIZE = 65536;
+
+void FixMessageDictionary::clear()
+{
+	sentIndices.clear();
+	receivedStrings.clear();
+}
+
+FixMessageWriter::FixMessageWriter(FixMessageDictionary& inDictionary, quint32 requestId, EFixMessageType type) :
+	dictionary(inDictionary)
+{
+	writeVarint(requestId);
+	writeVarint(static_cast<quint64>(type));
+}
+
+void FixMessageWriter::writeUnsigned(quint64 value)
+{
+	writeVarint(value);
+}
+
+void FixMessageWriter::writeCount(quint32 count)
+{
+	writeVarint(count);
+}
+
+void FixMessageWriter::writeInteger(qint32 value)
+{
+	const qint64 extended = value;
+	writeVarint((static_cast<quint64>(extended) << 1) ^ static_cast<quint64>(extended >> 63));
+}
+
+void FixMessageWriter::writeString(const QString& value)
+{
+	const QHash<QString, quint32>::const_iterator index = dictionary.sentIndices.constFind(value);
+	if (index != dictionary.sentIndices.constEnd())
+	{
+		writeVarint(static_cast<quint64>(index.value()) + 1);
+		return;
+	}
+
+	if (static_cast<quint32>(dictionary.sentIndices.size()) < MAX_DICTIONARY_SIZE)
+	{
+		dictionary.sentIndices.insert(value, static_cast<quint32>(dictionary.sentIndices.size()));
+	}
+
+	const QByteArray utf8 = value.toUtf8();
+	writeVarint(0);
+	writeVarint(static_cast<quint64>(utf8.size()));
+	message += utf8;
+}
+
+const QByteArray& FixMessageWriter::getMessage() const
+{
+	return message;
+}
+
+void FixMessageWriter::writeVarint(quint64 value)
+{
+	while (value >= 0x80)
+	{
+		message += static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	message += static_cast<char>(value);
+}
+
+FixMessageReader::FixMessageReader(FixMessageDictionary& inDictionary, const QByteArray& message) :
+	dictionary(inDictionary),
+	position(message.constData()),
+	end(message.constData() + message.size())
+{
+}
+
+bool FixMessageReader::readHeader(quint32& requestId, EFixMessageType& type)
+{
+	quint64 id = 0;
+	quint64 messageType = 0;
+	if (!readVarint(id) || !readVarint(messageType) ||
+		id > 0xFFFFFFFF || messageType > static_cast<quint64>(EFixMessageType::MarkFixed))
+	{
+		return false;
+	}
+
+	requestId = static_cast<quint32>(id);
+	type = static_cast<EFixMessageType>(messageType);
+	return true;
+}
+
+bool FixMessageReader::readUnsigned(quint64& value)
+{
+	return readVarint(value);
+}
+
+bool FixMessageReader::readCount(quint32& count)
+{
+	// Every counted element takes at least a byte, which rejects bogus counts before anything is reserved.
+	quint64 value = 0;
+	if (!readVarint(value) || value > static_cast<quint64>(end - position))
+	{
+		return false;
+	}
+
+	count = static_cast<quint32>(value);
+	return true;
+}
+
+bool FixMessageReader::readInteger(qint32& value)
+{
+	quint64 encoded = 0;
+	if (!readVarint(encoded))
+	{
+		return false;
+	}
+
+	value = static_cast<qint32>(static_cast<qint64>(encoded >> 1) ^ -static_cast<qint64>(encoded & 1));
+	return true;
+}
+
+bool FixMessageReader::readString(QString& value)
+{
+	quint64 reference = 0;
+	if (!readVarint(reference))
+	{
+		return false;
+	}
+
+	if (reference > 0)
+	{
+		if (reference > dictionary.receivedStrings.size())
+		{
+			return false;
+		}
+
+		value = dictionary.receivedStrings[reference - 1];
+		return true;
+	}
+
+	quint64 length = 0;
+	if (!readVarint(length) || length > static_cast<quint64>(end - position))
+	{
+		return false;
+	}
+
+	value = QString::fromUtf8(position, static_cast<int>(length));
+	position += length;
+	if (dictionary.receivedStrings.size() < MAX_DICTIONARY_SIZE)
+	{
+		dictionary.receivedStrings.push_back(value);
+	}
+	return true;
+}
+
+bool FixMessageReader::isAtEnd() const
+{
+	return position == end;
+}
+
+bool FixMessageReader::readVarint(quint64& value)
+{
+	value = 0;
+	for (qint32 shift = 0; position != end && shift < 64; shift += 7)
+	{
+		const quint8 byte = static_cast<quint8>(*position++);
+		value |= static_cast<quint64>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,98 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <qbytearray.h>
+#include <qhash.h>
+#include <qstring.h>
+
+#include <vector>
+
+// Messages exchanged with the fix server on a persistent connection, version 2 of the protocol. Every message
+// starts with the request ID and the message type as varints, a response repeats both of its request.
+//
+// FixState      request:  the last version of the fix table the client knows, zero if none.
+//               response: the current version, whether this is the full table rather than the changes since the
+//                         known version, the count of started fixes followed by their project name, user name and
+//                         build number, and the count of finished fixes followed by their project name.
+// ReportFixing  request:  project name, user name, build number. Empty response.
+// MarkFixed     request:  project name, build number. Empty response.
+// Error         response to a request that couldn't be handled, empty.
+//
+// Versions, counts and flags are varints, other integers are zigzag encoded varints. A string is a varint
+// reference: zero is followed by the length and UTF-8 data of a string that wasn't sent on the connection before,
+// which the receiver adds to its dictionary. Any other reference is the index plus one of a string in that
+// dictionary.
+enum class EFixMessageType : quint8
+{
+	Error,
+	FixState,
+	ReportFixing,
+	MarkFixed
+};
+
+// Strings sent and received on a single connection. Cleared when the connection is made again.
+struct FixMessageDictionary
+{
+	void clear();
+
+	QHash<QString, quint32> sentIndices;
+	std::vector<QString> receivedStrings;
+};
+
+class FixMessageWriter
+{
+public:
+	FixMessageWriter(FixMessageDictionary& inDictionary, quint32 requestId, EFixMessageType type);
+
+	void writeUnsigned(quint64 value);
+	void writeCount(quint32 count);
+	void writeInteger(qint32 value);
+	void writeString(const QString& value);
+
+	const QByteArray& getMessage() const;
+
+private:
+	void writeVarint(quint64 value);
+
+	FixMessageDictionary& dictionary;
+	QByteArray message;
+};
+
+// Decodes straight from the received frame. Strings that were received before are shared with the dictionary
+// instead of being decoded again. After a failed read the dictionary can be out of sync, so the connection should
+// be closed.
+class FixMessageReader
+{
+public:
+	FixMessageReader(FixMessageDictionary& inDictionary, const QByteArray& message);
+
+	bool readHeader(quint32& requestId, EFixMessageType& type);
+	bool readUnsigned(quint64& value);
+	bool readCount(quint32& count);
+	bool readInteger(qint32& value);
+	bool readString(QString& value);
+	bool isAtEnd() const;
+
+private:
+	bool readVarint(quint64& value);
+
+	FixMessageDictionary& dictionary;
+	const char* position;
+	const char* end;
+};
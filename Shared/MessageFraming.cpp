@@ -0,0 +1,136 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MessageFraming.h"
+
+#include <qendian.h>
+#include <qiodevice.h>
+
+constexpr int FRAME_HEADER_SIZE = sizeof(quint32);
+
+// Binary JSON starts with its tag and version, followed by the size of the root value.
+constexpr int BINARY_JSON_HEADER_SIZE = 2 * sizeof(quint32);
+constexpr int BINARY_JSON_SIZE_END = BINARY_JSON_HEADER_SIZE + sizeof(quint32);
+
+void writeMessageFrame(QIODevice& device, const QByteArray& message)
+{
+	Q_ASSERT(static_cast<quint32>(message.size()) <= MAX_MESSAGE_FRAME_SIZE);
+
+	uchar header[FRAME_HEADER_SIZE];
+	qToBigEndian<quint32>(message.size(), header);
+	device.write(reinterpret_cast<const char*>(header), FRAME_HEADER_SIZE);
+	device.write(message);
+}
+
+MessageFrameReader::MessageFrameReader() :
+	readOffset(0),
+	writeOffset(0),
+	isInvalid(false)
+{
+}
+
+void MessageFrameReader::readFrom(QIODevice& device)
+{
+	// Only the tail of an incomplete message is moved, complete messages were handed out in place.
+	if (readOffset == writeOffset)
+	{
+		readOffset = 0;
+		writeOffset = 0;
+	}
+	else if (readOffset > 0)
+	{
+		buffer.remove(0, readOffset);
+		writeOffset -= readOffset;
+		readOffset = 0;
+	}
+
+	const qint64 available = device.bytesAvailable();
+	if (available <= 0)
+	{
+		return;
+	}
+
+	if (buffer.size() < writeOffset + available)
+	{
+		buffer.resize(writeOffset + static_cast<int>(available));
+	}
+
+	const qint64 bytesRead = device.read(buffer.data() + writeOffset, available);
+	if (bytesRead > 0)
+	{
+		writeOffset += static_cast<int>(bytesRead);
+	}
+}
+
+void MessageFrameReader::clear()
+{
+	buffer.clear();
+	readOffset = 0;
+	writeOffset = 0;
+	isInvalid = false;
+}
+
+bool MessageFrameReader::nextFrame(QByteArray& message)
+{
+	if (isInvalid || writeOffset - readOffset < FRAME_HEADER_SIZE)
+	{
+		return false;
+	}
+
+	const quint32 messageSize = qFromBigEndian<quint32>(buffer.constData() + readOffset);
+	return takeMessage(FRAME_HEADER_SIZE, messageSize, message);
+}
+
+bool MessageFrameReader::nextUnframedMessage(QByteArray& message)
+{
+	if (isInvalid || writeOffset - readOffset < BINARY_JSON_SIZE_END)
+	{
+		return false;
+	}
+
+	const quint32 rootSize = qFromLittleEndian<quint32>(buffer.constData() + readOffset + BINARY_JSON_HEADER_SIZE);
+	if (rootSize > MAX_MESSAGE_FRAME_SIZE)
+	{
+		isInvalid = true;
+		return false;
+	}
+
+	return takeMessage(0, BINARY_JSON_HEADER_SIZE + rootSize, message);
+}
+
+bool MessageFrameReader::hasError() const
+{
+	return isInvalid;
+}
+
+bool MessageFrameReader::takeMessage(int headerSize, quint32 messageSize, QByteArray& message)
+{
+	if (messageSize > MAX_MESSAGE_FRAME_SIZE)
+	{
+		isInvalid = true;
+		return false;
+	}
+
+	if (static_cast<qint64>(writeOffset - readOffset) < static_cast<qint64>(headerSize) + messageSize)
+	{
+		return false;
+	}
+
+	message = QByteArray::fromRawData(buffer.constData() + readOffset + headerSize, static_cast<int>(messageSize));
+	readOffset += headerSize + static_cast<int>(messageSize);
+	return true;
+}
@@ -0,0 +1,56 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <qbytearray.h>
+
+class QIODevice;
+
+// Frames larger than this are treated as a protocol error, so a bad length can't exhaust memory.
+constexpr quint32 MAX_MESSAGE_FRAME_SIZE = 16 * 1024 * 1024;
+
+// Writes the message preceded by its length as a big endian 32-bit integer.
+void writeMessageFrame(QIODevice& device, const QByteArray& message);
+
+// Buffers the data of a connection until complete messages are available. Both length-prefixed frames and
+// unframed version 1 messages are supported, the latter are delimited by the size in their binary JSON header.
+class MessageFrameReader
+{
+public:
+	MessageFrameReader();
+
+	// Reads all available data of the device straight into the buffer. Invalidates messages returned before.
+	void readFrom(QIODevice& device);
+	void clear();
+
+	// Return false until a complete message is buffered. The message refers to the buffer without copying it,
+	// and is valid until the next call to readFrom or clear.
+	bool nextFrame(QByteArray& message);
+	bool nextUnframedMessage(QByteArray& message);
+
+	// Set once a message exceeds the maximum frame size, after which the connection should be closed.
+	bool hasError() const;
+
+private:
+	bool takeMessage(int headerSize, quint32 messageSize, QByteArray& message);
+
+	QByteArray buffer;
+	int readOffset;
+	int writeOffset;
+	bool isInvalid;
+};
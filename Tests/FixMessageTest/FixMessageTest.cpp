@@ -0,0 +1,254 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FixMessage.h"
+
+#include <qdebug.h>
+#include <qtest.h>
+
+#include <limits>
+
+// Reads a FixState response as the client does, false if any part of it is malformed.
+static bool readFixState(FixMessageDictionary& dictionary, const QByteArray& message)
+{
+	FixMessageReader reader(dictionary, message);
+	quint32 requestId = 0;
+	EFixMessageType type = EFixMessageType::Error;
+	quint64 version = 0;
+	quint64 isFullState = 0;
+	quint32 startedCount = 0;
+	if (!reader.readHeader(requestId, type) || !reader.readUnsigned(version) || !reader.readUnsigned(isFullState) ||
+		!reader.readCount(startedCount))
+	{
+		return false;
+	}
+
+	for (quint32 i = 0; i < startedCount; ++i)
+	{
+		QString projectName;
+		QString userName;
+		qint32 buildNumber = 0;
+		if (!reader.readString(projectName) || !reader.readString(userName) || !reader.readInteger(buildNumber))
+		{
+			return false;
+		}
+	}
+
+	quint32 finishedCount = 0;
+	if (!reader.readCount(finishedCount))
+	{
+		return false;
+	}
+
+	for (quint32 i = 0; i < finishedCount; ++i)
+	{
+		QString projectName;
+		if (!reader.readString(projectName))
+		{
+			return false;
+		}
+	}
+	return reader.isAtEnd();
+}
+
+static QByteArray writeFixState(FixMessageDictionary& dictionary, quint32 fixCount)
+{
+	FixMessageWriter writer(dictionary, 1, EFixMessageType::FixState);
+	writer.writeUnsigned(42);
+	writer.writeUnsigned(1);
+	writer.writeCount(fixCount);
+	for (quint32 i = 0; i < fixCount; ++i)
+	{
+		writer.writeString(QString("Project %1").arg(i));
+		writer.writeString(QString("User %1").arg(i % 10));
+		writer.writeInteger(static_cast<qint32>(1000 + i));
+	}
+	writer.writeCount(1);
+	writer.writeString("Project 0");
+	return writer.getMessage();
+}
+
+class FixMessageTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void roundTrip();
+	void repeatedStrings();
+	void truncatedMessages();
+	void malformedMessages();
+	void randomMessages();
+	void fixStateSize();
+	void encodeFixState();
+	void decodeFixState();
+};
+
+void FixMessageTest::roundTrip()
+{
+	const std::vector<qint32> integers = { 0, 1, -1, 63, -64, 64, std::numeric_limits<qint32>::max(), std::numeric_limits<qint32>::min() };
+	const std::vector<quint64> unsignedValues = { 0, 127, 128, 16383, 16384, std::numeric_limits<quint64>::max() };
+	const std::vector<QString> strings = { QString(), "Project", QString::fromUtf8("Pr\xC3\xB6ject \xE2\x9C\x93") };
+
+	FixMessageDictionary writerDictionary;
+	FixMessageWriter writer(writerDictionary, 0xFFFFFFFF, EFixMessageType::ReportFixing);
+	for (const quint64 value : unsignedValues)
+	{
+		writer.writeUnsigned(value);
+	}
+	for (const qint32 value : integers)
+	{
+		writer.writeInteger(value);
+	}
+	writer.writeCount(static_cast<quint32>(strings.size()));
+	for (const QString& value : strings)
+	{
+		writer.writeString(value);
+	}
+
+	FixMessageDictionary readerDictionary;
+	FixMessageReader reader(readerDictionary, writer.getMessage());
+	quint32 requestId = 0;
+	EFixMessageType type = EFixMessageType::Error;
+	QVERIFY(reader.readHeader(requestId, type));
+	QCOMPARE(requestId, 0xFFFFFFFFu);
+	QVERIFY(type == EFixMessageType::ReportFixing);
+	for (const quint64 expected : unsignedValues)
+	{
+		quint64 value = 0;
+		QVERIFY(reader.readUnsigned(value));
+		QCOMPARE(value, expected);
+	}
+	for (const qint32 expected : integers)
+	{
+		qint32 value = 0;
+		QVERIFY(reader.readInteger(value));
+		QCOMPARE(value, expected);
+	}
+	quint32 count = 0;
+	QVERIFY(reader.readCount(count));
+	QCOMPARE(count, static_cast<quint32>(strings.size()));
+	for (const QString& expected : strings)
+	{
+		QString value;
+		QVERIFY(reader.readString(value));
+		QCOMPARE(value, expected);
+	}
+	QVERIFY(reader.isAtEnd());
+}
+
+void FixMessageTest::repeatedStrings()
+{
+	FixMessageDictionary writerDictionary;
+	FixMessageDictionary readerDictionary;
+	const QByteArray first = writeFixState(writerDictionary, 10);
+	const QByteArray second = writeFixState(writerDictionary, 10);
+
+	// The second message only refers to the strings of the first.
+	QVERIFY(second.size() < first.size() / 2);
+	QVERIFY(readFixState(readerDictionary, first));
+	QVERIFY(readFixState(readerDictionary, second));
+
+	// Without the strings of the first message the references can't be resolved.
+	FixMessageDictionary emptyDictionary;
+	QVERIFY(!readFixState(emptyDictionary, second));
+}
+
+void FixMessageTest::truncatedMessages()
+{
+	FixMessageDictionary writerDictionary;
+	const QByteArray message = writeFixState(writerDictionary, 5);
+	for (int size = 0; size < message.size(); ++size)
+	{
+		FixMessageDictionary readerDictionary;
+		QVERIFY2(!readFixState(readerDictionary, message.left(size)), qPrintable(QString("Size %1").arg(size)));
+	}
+}
+
+void FixMessageTest::malformedMessages()
+{
+	FixMessageDictionary dictionary;
+	quint32 requestId = 0;
+	EFixMessageType type = EFixMessageType::Error;
+
+	// A varint longer than 64 bits.
+	const QByteArray overlong(11, static_cast<char>(0xFF));
+	quint64 value = 0;
+	QVERIFY(!FixMessageReader(dictionary, overlong).readUnsigned(value));
+
+	// A request ID beyond 32 bits, and an unknown message type.
+	QVERIFY(!FixMessageReader(dictionary, QByteArray("\x80\x80\x80\x80\x10\x01", 6)).readHeader(requestId, type));
+	QVERIFY(!FixMessageReader(dictionary, QByteArray("\x01\x04", 2)).readHeader(requestId, type));
+
+	// A count of more elements than there are bytes left.
+	quint32 count = 0;
+	QVERIFY(!FixMessageReader(dictionary, QByteArray("\x05\x00\x00", 3)).readCount(count));
+
+	// A string longer than the message, and a reference to a string that wasn't received.
+	QString string;
+	QVERIFY(!FixMessageReader(dictionary, QByteArray("\x00\x05\x41", 3)).readString(string));
+	QVERIFY(!FixMessageReader(dictionary, QByteArray("\x01", 1)).readString(string));
+}
+
+void FixMessageTest::randomMessages()
+{
+	// Anything may be received, decoding has to fail without reading past the message.
+	quint32 state = 12345;
+	for (int i = 0; i < 10000; ++i)
+	{
+		QByteArray message;
+		const int size = static_cast<int>(state % 64);
+		for (int j = 0; j < size; ++j)
+		{
+			state = state * 1664525u + 1013904223u;
+			message += static_cast<char>(state >> 24);
+		}
+
+		FixMessageDictionary dictionary;
+		readFixState(dictionary, message);
+	}
+}
+
+void FixMessageTest::fixStateSize()
+{
+	FixMessageDictionary dictionary;
+	const QByteArray message = writeFixState(dictionary, 1000);
+	qDebug() << "FixState of 1000 fixes:" << message.size() << "bytes, repeated:" << writeFixState(dictionary, 1000).size() << "bytes";
+}
+
+void FixMessageTest::encodeFixState()
+{
+	QBENCHMARK
+	{
+		FixMessageDictionary dictionary;
+		writeFixState(dictionary, 1000);
+	}
+}
+
+void FixMessageTest::decodeFixState()
+{
+	FixMessageDictionary writerDictionary;
+	const QByteArray message = writeFixState(writerDictionary, 1000);
+	QBENCHMARK
+	{
+		FixMessageDictionary readerDictionary;
+		QVERIFY(readFixState(readerDictionary, message));
+	}
+}
+
+QTEST_APPLESS_MAIN(FixMessageTest)
+
+#include "FixMessageTest.moc"
@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Round trip, malformed input and benchmarks of the fix server messages.
+# Run with "make check".
+#
+#-------------------------------------------------
+
+QT       += testlib
+QT       -= gui
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TARGET = FixMessageTest
+TEMPLATE = app
+unix:QMAKE_CXXFLAGS += -std=c++11
+
+INCLUDEPATH += ../../Shared
+
+SOURCES += FixMessageTest.cpp \
+    ../../Shared/FixMessage.cpp
+
+HEADERS  += \
+    ../../Shared/FixMessage.h
@@ -0,0 +1,274 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JenkinsEventStream.h"
+
+#include <qnetworkproxy.h>
+#include <qsignalspy.h>
+#include <qtcpserver.h>
+#include <qtcpsocket.h>
+#include <qtest.h>
+#include <qtimer.h>
+
+#include <map>
+
+// Recorded from the SSE Gateway of a Jenkins server, a keepalive followed by job events. The second event was
+// sent with CRLF line endings, the third one with its data split over two lines.
+constexpr const char* RECORDED_EVENTS =
+	":\n"
+	"\n"
+	"id: 1\n"
+	"event: job\n"
+	"data: {\"jenkins_channel\":\"job\",\"jenkins_event\":\"job_run_started\",\"job_name\":\"Alpha\",\"jenkins_object_type\":\"hudson.model.FreeStyleBuild\"}\n"
+	"\n"
+	"id: 2\r\n"
+	"event: job\r\n"
+	"data: {\"jenkins_channel\":\"job\",\"jenkins_event\":\"job_run_queue_enter\",\"job_name\":\"Beta\"}\r\n"
+	"\r\n"
+	"id: 3\n"
+	"event: job\n"
+	"data: {\"jenkins_channel\":\"job\",\"jenkins_event\":\"job_run_ended\",\n"
+	"data: \"job_name\":\"Alpha\",\"job_run_status\":\"SUCCESS\"}\n"
+	"\n"
+	"id: 4\n"
+	"event: job\n"
+	"data: {\"jenkins_channel\":\"job\",\"jenkins_event\":\"job_crud_created\",\"job_name\":\"Gamma\"}\n"
+	"\n";
+
+constexpr qint32 REPLAY_CHUNK_SIZE = 7; // Splits lines over several reads.
+constexpr qint32 IDLE_TIMEOUT_MS = 500;
+constexpr qint32 KEEPALIVE_INTERVAL_MS = 100;
+constexpr qint32 RECONNECT_TIMEOUT_MS = 5000;
+
+// Stands in for the SSE Gateway: answers connect and configure requests and keeps the listen request open, on
+// which the test replays events.
+class ReplayServer
+{
+public:
+	ReplayServer() :
+		streamSocket(nullptr)
+	{
+		QObject::connect(&server, &QTcpServer::newConnection, [this]()
+		{
+			while (QTcpSocket* socket = server.nextPendingConnection())
+			{
+				QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() { onDataReceived(socket); });
+				QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+				QObject::connect(socket, &QObject::destroyed, &server, [this, socket]()
+				{
+					requestBuffers.erase(socket);
+					if (streamSocket == socket)
+					{
+						streamSocket = nullptr;
+					}
+				});
+			}
+		});
+	}
+
+	bool listen()
+	{
+		return server.listen(QHostAddress::LocalHost);
+	}
+
+	QUrl getURL() const
+	{
+		return QUrl(QString("http://127.0.0.1:%1").arg(server.serverPort()));
+	}
+
+	const QStringList& getRequests() const
+	{
+		return requests;
+	}
+
+	bool isStreaming() const
+	{
+		return streamSocket != nullptr;
+	}
+
+	void replay(const QByteArray& events)
+	{
+		for (int i = 0; i < events.size(); i += REPLAY_CHUNK_SIZE)
+		{
+			streamSocket->write(events.mid(i, REPLAY_CHUNK_SIZE));
+			streamSocket->flush();
+		}
+	}
+
+	void closeStream()
+	{
+		streamSocket->disconnectFromHost();
+	}
+
+private:
+	void onDataReceived(QTcpSocket* socket)
+	{
+		QByteArray& buffer = requestBuffers[socket];
+		buffer += socket->readAll();
+		const int headerEnd = buffer.indexOf("\r\n\r\n");
+		if (headerEnd == -1)
+		{
+			return;
+		}
+
+		// Wait for the body, closing the connection before it is read resets it.
+		qint32 contentLength = 0;
+		for (const QByteArray& header : buffer.left(headerEnd).split('\n'))
+		{
+			if (header.toLower().startsWith("content-length:"))
+			{
+				contentLength = header.mid(header.indexOf(':') + 1).trimmed().toInt();
+			}
+		}
+		if (buffer.size() < headerEnd + 4 + contentLength)
+		{
+			return;
+		}
+
+		const QList<QByteArray> requestLine = buffer.left(buffer.indexOf("\r\n")).split(' ');
+		const QString request = QString::fromLatin1(requestLine.value(0)) + ' ' + QUrl(QString::fromLatin1(requestLine.value(1))).path();
+		requests.append(request);
+		buffer.clear();
+
+		if (request.startsWith("GET /sse-gateway/listen/"))
+		{
+			socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n");
+			socket->write("event: open\ndata: {\"dispatcherId\":\"dispatcher-1\"}\n\n");
+			streamSocket = socket;
+			return;
+		}
+
+		socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+		socket->disconnectFromHost();
+	}
+
+	QTcpSocket* streamSocket; // Open listen request.
+	std::map<QTcpSocket*, QByteArray> requestBuffers;
+	QStringList requests;
+	QTcpServer server; // Last, its sockets refer to the other members when they are destroyed.
+};
+
+class JenkinsEventStreamTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void replayRecordedEvents();
+	void reconnectAfterClose();
+	void keepaliveKeepsStream();
+	void reconnectAfterSilentDrop();
+};
+
+void JenkinsEventStreamTest::initTestCase()
+{
+	QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+}
+
+void JenkinsEventStreamTest::replayRecordedEvents()
+{
+	ReplayServer server;
+	QVERIFY(server.listen());
+
+	JenkinsEventStream stream(server.getURL(), nullptr);
+	QSignalSpy connectedSpy(&stream, &JenkinsEventStream::connected);
+	QSignalSpy disconnectedSpy(&stream, &JenkinsEventStream::disconnected);
+	QSignalSpy buildSpy(&stream, &JenkinsEventStream::jobBuildChanged);
+	QSignalSpy listSpy(&stream, &JenkinsEventStream::jobListChanged);
+	stream.start();
+
+	QTRY_COMPARE(connectedSpy.count(), 1);
+	QVERIFY(stream.isConnected());
+	QCOMPARE(server.getRequests().size(), 3);
+	QCOMPARE(server.getRequests()[0], QString("GET /sse-gateway/connect"));
+	QVERIFY(server.getRequests()[1].startsWith("GET /sse-gateway/listen/"));
+	QCOMPARE(server.getRequests()[2], QString("POST /sse-gateway/configure"));
+
+	server.replay(RECORDED_EVENTS);
+	QTRY_COMPARE(listSpy.count(), 1);
+	QCOMPARE(buildSpy.count(), 2);
+	QCOMPARE(buildSpy[0][0].toString(), QString("Alpha"));
+	QCOMPARE(buildSpy[1][0].toString(), QString("Alpha"));
+	QCOMPARE(disconnectedSpy.count(), 0);
+}
+
+void JenkinsEventStreamTest::reconnectAfterClose()
+{
+	ReplayServer server;
+	QVERIFY(server.listen());
+
+	JenkinsEventStream stream(server.getURL(), nullptr);
+	QSignalSpy connectedSpy(&stream, &JenkinsEventStream::connected);
+	QSignalSpy disconnectedSpy(&stream, &JenkinsEventStream::disconnected);
+	stream.start();
+	QTRY_COMPARE(connectedSpy.count(), 1);
+
+	server.closeStream();
+	QTRY_COMPARE(disconnectedSpy.count(), 1);
+	QVERIFY(!stream.isConnected());
+
+	QTRY_COMPARE_WITH_TIMEOUT(connectedSpy.count(), 2, RECONNECT_TIMEOUT_MS);
+	QVERIFY(stream.isConnected());
+}
+
+void JenkinsEventStreamTest::keepaliveKeepsStream()
+{
+	ReplayServer server;
+	QVERIFY(server.listen());
+
+	JenkinsEventStream stream(server.getURL(), nullptr);
+	stream.setIdleTimeout(IDLE_TIMEOUT_MS);
+	QSignalSpy connectedSpy(&stream, &JenkinsEventStream::connected);
+	QSignalSpy disconnectedSpy(&stream, &JenkinsEventStream::disconnected);
+	stream.start();
+	QTRY_COMPARE(connectedSpy.count(), 1);
+
+	QTimer keepaliveTimer;
+	QObject::connect(&keepaliveTimer, &QTimer::timeout, [&server]() { server.replay(":\n\n"); });
+	keepaliveTimer.start(KEEPALIVE_INTERVAL_MS);
+	QTest::qWait(IDLE_TIMEOUT_MS * 3);
+
+	QCOMPARE(disconnectedSpy.count(), 0);
+	QVERIFY(stream.isConnected());
+}
+
+void JenkinsEventStreamTest::reconnectAfterSilentDrop()
+{
+	ReplayServer server;
+	QVERIFY(server.listen());
+
+	JenkinsEventStream stream(server.getURL(), nullptr);
+	stream.setIdleTimeout(IDLE_TIMEOUT_MS);
+	QSignalSpy connectedSpy(&stream, &JenkinsEventStream::connected);
+	QSignalSpy disconnectedSpy(&stream, &JenkinsEventStream::disconnected);
+	QSignalSpy buildSpy(&stream, &JenkinsEventStream::jobBuildChanged);
+	stream.start();
+	QTRY_COMPARE(connectedSpy.count(), 1);
+
+	// The connection stays open but nothing arrives anymore.
+	QTRY_COMPARE_WITH_TIMEOUT(disconnectedSpy.count(), 1, IDLE_TIMEOUT_MS * 4);
+	QVERIFY(!stream.isConnected());
+
+	QTRY_COMPARE_WITH_TIMEOUT(connectedSpy.count(), 2, RECONNECT_TIMEOUT_MS);
+	QVERIFY(server.isStreaming());
+	server.replay(RECORDED_EVENTS);
+	QTRY_COMPARE(buildSpy.count(), 2);
+}
+
+QTEST_GUILESS_MAIN(JenkinsEventStreamTest)
+
+#include "JenkinsEventStreamTest.moc"
@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Event stream against a local server that replays a recorded SSE Gateway stream.
+# Run with "make check".
+#
+#-------------------------------------------------
+
+QT       += network testlib
+QT       -= gui
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TARGET = JenkinsEventStreamTest
+TEMPLATE = app
+unix:QMAKE_CXXFLAGS += -std=c++11
+
+INCLUDEPATH += ../../BuildMonitor
+
+SOURCES += JenkinsEventStreamTest.cpp \
+    ../../BuildMonitor/JenkinsEventStream.cpp
+
+HEADERS  += \
+    ../../BuildMonitor/JenkinsEventStream.h
@@ -0,0 +1,246 @@
+/* BuildMonitor - Monitor the state of projects in CI.
+ * Copyright (C) 2017 Sander Brattinga
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JenkinsJobListParser.h"
+
+#include <qjsonarray.h>
+#include <qjsondocument.h>
+#include <qjsonobject.h>
+#include <qtest.h>
+
+#include <algorithm>
+
+constexpr qint32 BENCHMARK_JOB_COUNT = 10000; // Several MB, as listed by a folder heavy server.
+constexpr qint32 RECEIVE_CHUNK_SIZE = 16384; // Roughly what a readyRead delivers.
+
+static QByteArray writeBuild(qint32 number, qint32 culpritCount)
+{
+	QByteArray build = "{\"_class\":\"hudson.model.FreeStyleBuild\",\"culprits\":[";
+	for (qint32 i = 0; i < culpritCount; ++i)
+	{
+		build += (i == 0 ? "" : ",") + QByteArray("{\"fullName\":\"User ") + QByteArray::number(i) + "\"}";
+	}
+	build += "],\"duration\":" + QByteArray::number(60000 + number);
+	build += ",\"estimatedDuration\":" + QByteArray::number(61000 + number);
+	build += ",\"number\":" + QByteArray::number(number);
+	build += ",\"timestamp\":" + QByteArray::number(Q_INT64_C(1500000000000) + number) + "}";
+	return build;
+}
+
+// A listing as returned for the tree the client requests, with names that need escaping and values the
+// client doesn't use.
+static QByteArray writeListing(qint32 jobCount)
+{
+	QByteArray listing = "{\"_class\":\"hudson.model.Hudson\",\"description\":null,\"jobs\":[";
+	for (qint32 i = 0; i < jobCount; ++i)
+	{
+		const QByteArray name = i % 10 == 0 ? "Pr\\u00f6ject \\\"" + QByteArray::number(i) + "\\\"" : "Project " + QByteArray::number(i);
+		listing += i == 0 ? "\n" : ",\n";
+		listing += "  {\"_class\":\"hudson.model.FreeStyleProject\",\"name\":\"" + name + "\",";
+		listing += "\"url\":\"http://jenkins.example.com/job/Project%20" + QByteArray::number(i) + "/\",";
+		listing += "\"color\":\"" + QByteArray(i % 3 == 0 ? "red" : "blue_anime") + "\",";
+		listing += "\"healthReport\":[{\"score\":80,\"iconUrl\":\"health-60to79.png\"}],\"buildable\":true,";
+		if (i % 5 == 0)
+		{
+			listing += "\"lastBuild\":null";
+		}
+		else
+		{
+			listing += "\"lastBuild\":" + writeBuild(i, i % 4);
+			listing += ",\"lastSuccessfulBuild\":" + writeBuild(i - 1, 0);
+		}
+		listing += "}";
+	}
+	listing += "\n]}";
+	return listing;
+}
+
+static std::vector<JenkinsJobInformation> parseChunks(const QByteArray& listing, qint32 chunkSize, bool& isComplete)
+{
+	JenkinsJobListParser parser;
+	std::vector<JenkinsJobInformation> jobs;
+	for (qint32 i = 0; i < listing.size(); i += chunkSize)
+	{
+		parser.parse(listing.mid(i, chunkSize));
+		for (JenkinsJobInformation& job : parser.takeJobs())
+		{
+			jobs.emplace_back(std::move(job));
+		}
+	}
+	isComplete = parser.finish();
+	for (JenkinsJobInformation& job : parser.takeJobs())
+	{
+		jobs.emplace_back(std::move(job));
+	}
+	return jobs;
+}
+
+static JenkinsBuildInformation parseDocumentBuild(const QJsonObject& object)
+{
+	JenkinsBuildInformation build;
+	build.number = object["number"].toInt();
+	build.duration = object["duration"].toDouble();
+	build.timestamp = object["timestamp"].toDouble();
+	build.estimatedDuration = object["estimatedDuration"].toDouble();
+
+	const QJsonArray culprits = object["culprits"].toArray();
+	for (const QJsonValue culprit : culprits)
+	{
+		if (culprit.isObject())
+		{
+			build.culprits.emplace_back(culprit.toObject()["fullName"].toString());
+		}
+	}
+
+	return build;
+}
+
+// The way listings were parsed before, the whole response into a document.
+static std::vector<JenkinsJobInformation> parseDocument(const QByteArray& listing)
+{
+	std::vector<JenkinsJobInformation> jobs;
+
+	const QJsonArray projects = QJsonDocument::fromJson(listing).object()["jobs"].toArray();
+	jobs.reserve(projects.size());
+	for (const QJsonValue& project : projects)
+	{
+		if (project.isObject())
+		{
+			const QJsonObject object = project.toObject();
+			JenkinsJobInformation job;
+			job.name = object["name"].toString();
+			job.url = object["url"].toString();
+			job.color = object["color"].toString();
+			job.hasBuildInformation = object.contains("lastSuccessfulBuild");
+
+			const QJsonValue lastBuild = object["lastBuild"];
+			if (lastBuild.isObject())
+			{
+				job.lastBuild = parseDocumentBuild(lastBuild.toObject());
+			}
+
+			const QJsonValue lastSuccessfulBuild = object["lastSuccessfulBuild"];
+			if (lastSuccessfulBuild.isObject())
+			{
+				job.lastSuccessfulBuild = parseDocumentBuild(lastSuccessfulBuild.toObject());
+			}
+
+			jobs.emplace_back(job);
+		}
+	}
+
+	return jobs;
+}
+
+static bool isSameBuild(const JenkinsBuildInformation& first, const JenkinsBuildInformation& second)
+{
+	return first.number == second.number && first.duration == second.duration && first.timestamp == second.timestamp &&
+		first.estimatedDuration == second.estimatedDuration && first.culprits == second.culprits;
+}
+
+static bool isSameJobs(const std::vector<JenkinsJobInformation>& first, const std::vector<JenkinsJobInformation>& second)
+{
+	return first.size() == second.size() && std::equal(first.begin(), first.end(), second.begin(),
+		[](const JenkinsJobInformation& firstJob, const JenkinsJobInformation& secondJob)
+	{
+		return firstJob.name == secondJob.name && firstJob.url == secondJob.url && firstJob.color == secondJob.color &&
+			firstJob.hasBuildInformation == secondJob.hasBuildInformation && isSameBuild(firstJob.lastBuild, secondJob.lastBuild) &&
+			isSameBuild(firstJob.lastSuccessfulBuild, secondJob.lastSuccessfulBuild);
+	});
+}
+
+class JenkinsJobListParserTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void sameAsDocument();
+	void chunkSizes();
+	void truncatedListing();
+	void malformedListing();
+	void parseListing();
+	void parseListingDocument();
+};
+
+void JenkinsJobListParserTest::sameAsDocument()
+{
+	const QByteArray listing = writeListing(100);
+	bool isComplete = false;
+	const std::vector<JenkinsJobInformation> jobs = parseChunks(listing, listing.size(), isComplete);
+	QVERIFY(isComplete);
+	QCOMPARE(jobs.size(), size_t(100));
+	QCOMPARE(jobs[0].name, QString::fromUtf8("Pr\xC3\xB6ject \"0\""));
+	QCOMPARE(jobs[1].lastBuild.culprits.size(), size_t(1));
+	QVERIFY(isSameJobs(jobs, parseDocument(listing)));
+}
+
+void JenkinsJobListParserTest::chunkSizes()
+{
+	const QByteArray listing = writeListing(20);
+	bool isComplete = false;
+	const std::vector<JenkinsJobInformation> expectedJobs = parseChunks(listing, listing.size(), isComplete);
+	for (const qint32 chunkSize : { 1, 2, 3, 7, 64, 1000 })
+	{
+		const std::vector<JenkinsJobInformation> jobs = parseChunks(listing, chunkSize, isComplete);
+		QVERIFY(isComplete);
+		QVERIFY(isSameJobs(jobs, expectedJobs));
+	}
+}
+
+void JenkinsJobListParserTest::truncatedListing()
+{
+	const QByteArray listing = writeListing(3);
+	for (int size = 0; size < listing.size(); ++size)
+	{
+		bool isComplete = true;
+		parseChunks(listing.left(size), 5, isComplete);
+		QVERIFY2(!isComplete, qPrintable(QString("Complete at %1 bytes").arg(size)));
+	}
+}
+
+void JenkinsJobListParserTest::malformedListing()
+{
+	for (const char* listing : { "{\"jobs\":[}", "{\"jobs\":[]]", "{\"jobs\":[]} {}", "{\"jobs\":[{\"name\":\"\\u12\"}]}" })
+	{
+		bool isComplete = true;
+		parseChunks(listing, 4, isComplete);
+		QVERIFY2(!isComplete, listing);
+	}
+}
+
+void JenkinsJobListParserTest::parseListing()
+{
+	const QByteArray listing = writeListing(BENCHMARK_JOB_COUNT);
+	QBENCHMARK
+	{
+		bool isComplete = false;
+		QCOMPARE(parseChunks(listing, RECEIVE_CHUNK_SIZE, isComplete).size(), size_t(BENCHMARK_JOB_COUNT));
+	}
+}
+
+void JenkinsJobListParserTest::parseListingDocument()
+{
+	const QByteArray listing = writeListing(BENCHMARK_JOB_COUNT);
+	QBENCHMARK
+	{
+		QCOMPARE(parseDocument(listing).size(), size_t(BENCHMARK_JOB_COUNT));
+	}
+}
+
+QTEST_APPLESS_MAIN(JenkinsJobListParserTest)
+
+#include "JenkinsJobListParserTest.moc"
@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Chunked parsing of Jenkins server listings, and a benchmark against parsing them into a QJsonDocument.
+# Run with "make check".
+#
+#-------------------------------------------------
+
+QT       += testlib
+QT       -= gui
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TARGET = JenkinsJobListParserTest
+TEMPLATE = app
+unix:QMAKE_CXXFLAGS += -std=c++11
+
+INCLUDEPATH += ../../BuildMonitor
+
+SOURCES += JenkinsJobListParserTest.cpp \
+    ../../BuildMonitor/JenkinsJobListParser.cpp
+
+HEADERS  += \
+    ../../BuildMonitor/JenkinsJobInformation.h \
+    ../../BuildMonitor/JenkinsJobListParser.h